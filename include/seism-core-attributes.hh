@@ -24,6 +24,44 @@ class seismCoreAttributes
         int use_function_argc;
         char* use_function_argv;
 
+        // metadata cache, file space and page buffer tuning; set after
+        // construction, zero (or empty) means the HDF5 default
+        hsize_t mdc_size[3];            // initial, min, max
+        int mdc_no_evictions;
+        char* file_space_strategy;
+        int file_space_persist;
+        hsize_t file_space_page_size;
+        hsize_t page_buffer_size;
+        hsize_t meta_block_size;
+        int coll_metadata_write;
+        int evict_on_close;
+
+        // the filter chain after deflate and zfp, stages separated by ';'
+        char* filters;
+
+        // element types in the file and in memory ("f32", "f64", "f16", 
+        // "i16", "i32"), the factor values were multiplied by, and whether
+        // seism-core rather than HDF5 converted between the two types
+        char* element_type;
+        char* memory_type;
+        double type_scale;
+        int own_conversion;
+
+        // the block sizes along each axis of an irregular decomposition, the
+        // three lists separated by ';', or "" if every block is domain_dims
+        char* decomposition;
+
+        // the number of files the blocks were written to, next to this one,
+        // whose datasets are virtual and map them; 0 if the data is here
+        int piece_files;
+
+        // written with the subfiling VFD of HDF5 1.14+: its stripe size (0 
+        // for the library default) and how the I/O concentrators were 
+        // chosen ("" for the default, one per node)
+        int subfiling;
+        hsize_t subfiling_stripe_size;
+        char* subfiling_ioc;
+
         // constructor to create a new attributes object from simulation
         seismCoreAttributes
         (
@@ -65,6 +103,7 @@ class seismCoreAttributes
     private:
 
         void init(); // create H5 objects used internally
+        void clear_tuning(); // tuning and filter members to their defaults
 
         bool is_finalized;
 
@@ -0,0 +1,149 @@
+// seism-core-decomposition.hh
+#ifndef SEISM_CORE_DECOMPOSITION_HH
+#define SEISM_CORE_DECOMPOSITION_HH
+
+// Decompositions of the global domain into the blocks of the process grid.
+// They are rectilinear: along each axis a list of block sizes, one per
+// process in that direction, so that block (i, j, k) has sizes[0][i] x
+// sizes[1][j] x sizes[2][k] elements. A regular decomposition has
+// processor[d] blocks of domain[d] each; irregular ones come from split
+// lists or random sizes. Files keep the lists in their attributes, as
+// "sizes;sizes;sizes" with the sizes separated by spaces, or "" if regular.
+
+#include "hdf5.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct seism_core_decomposition
+{
+    std::vector<hsize_t> sizes[3];
+    std::vector<hsize_t> offsets[3];   // where each block starts
+};
+
+inline void set_offsets(seism_core_decomposition& dec)
+{
+    for (int d = 0; d < 3; d++)
+    {
+        dec.offsets[d].assign(dec.sizes[d].size(), 0);
+        for (size_t i = 1; i < dec.sizes[d].size(); i++)
+            dec.offsets[d][i] = dec.offsets[d][i - 1] + dec.sizes[d][i - 1];
+    }
+}
+
+inline seism_core_decomposition regular_decomposition
+(
+    const hsize_t* processor,
+    const hsize_t* domain
+)
+{
+    seism_core_decomposition dec;
+    for (int d = 0; d < 3; d++) dec.sizes[d].assign(processor[d], domain[d]);
+    set_offsets(dec);
+    return dec;
+}
+
+inline bool is_regular(const seism_core_decomposition& dec)
+{
+    for (int d = 0; d < 3; d++)
+        for (size_t i = 1; i < dec.sizes[d].size(); i++)
+            if (dec.sizes[d][i] != dec.sizes[d][0]) return false;
+    return true;
+}
+
+// the global extent along an axis
+inline hsize_t decomposition_extent(const seism_core_decomposition& dec, int d)
+{
+    return dec.sizes[d].empty() ? 0 : dec.offsets[d].back() + dec.sizes[d].back();
+}
+
+// the block with this number in the process grid
+inline void decomposition_block
+(
+    const seism_core_decomposition& dec,
+    const hsize_t*                  number,
+    hsize_t*                        start,
+    hsize_t*                        size
+)
+{
+    for (int d = 0; d < 3; d++)
+    {
+        start[d] = dec.offsets[d][number[d]];
+        size[d] = dec.sizes[d][number[d]];
+    }
+}
+
+// "" for a regular decomposition, else the lists as stored in the file
+inline std::string decomposition_string(const seism_core_decomposition& dec)
+{
+    if (is_regular(dec)) return "";
+    std::ostringstream ost;
+    for (int d = 0; d < 3; d++)
+    {
+        if (d) ost << ";";
+        for (size_t i = 0; i < dec.sizes[d].size(); i++)
+            ost << (i ? " " : "") << dec.sizes[d][i];
+    }
+    return ost.str();
+}
+
+// the decomposition of a file: the stored lists, or regular if there are
+// none; false if they don't match the process grid
+inline bool read_decomposition
+(
+    const char*               text,
+    const hsize_t*            processor,
+    const hsize_t*            domain,
+    seism_core_decomposition& dec
+)
+{
+    dec = regular_decomposition(processor, domain);
+    if (!text || !text[0]) return true;
+    std::istringstream lists(text);
+    std::string list;
+    for (int d = 0; d < 3; d++)
+    {
+        if (!std::getline(lists, list, ';')) return false;
+        std::istringstream in(list);
+        dec.sizes[d].clear();
+        hsize_t size;
+        while (in >> size) dec.sizes[d].push_back(size);
+        if (dec.sizes[d].size() != processor[d]) return false;
+    }
+    set_offsets(dec);
+    return true;
+}
+
+// How many chunks of the global domain, per timestep and variable, hold
+// elements of more than one block, and how many chunks there are. Along
+// each axis a chunk is either inside one block or not, and a chunk is
+// shared if it is along any axis.
+inline unsigned long long shared_chunks
+(
+    const seism_core_decomposition& dec,
+    const hsize_t*                  chunk,
+    unsigned long long*             n_chunks
+)
+{
+    unsigned long long total = 1, unshared = 1;
+    for (int d = 0; d < 3; d++)
+    {
+        hsize_t extent = decomposition_extent(dec, d);
+        hsize_t n = (extent + chunk[d] - 1) / chunk[d], inside = 0;
+        size_t b = 0;
+        for (hsize_t c = 0; c < n; c++)
+        {
+            hsize_t begin = c * chunk[d], end = std::min(begin + chunk[d], extent);
+            while (dec.offsets[d][b] + dec.sizes[d][b] <= begin) b++;
+            if (dec.offsets[d][b] + dec.sizes[d][b] >= end) inside++;
+        }
+        total *= n;
+        unshared *= inside;
+    }
+    if (n_chunks) *n_chunks = total;
+    return total - unshared;
+}
+
+#endif
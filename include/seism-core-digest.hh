@@ -0,0 +1,31 @@
+// seism-core-digest.hh
+#ifndef SEISM_CORE_DIGEST_HH
+#define SEISM_CORE_DIGEST_HH
+
+#include <stdint.h>
+#include <stddef.h>
+
+// companion dataset holding one digest per (timestep, block), with the same
+// time x processor grid shape as the blocks in the chunked dataset
+#define DIGEST_DSET_NAME "digests"
+#define DIGEST_ALGORITHM "xxh64"
+
+// 64-bit xxHash (XXH64, seed 0) of len bytes
+uint64_t seism_core_digest(const void* data, size_t len);
+
+// the same digest of data passed in pieces: init, update for every piece, 
+// then final
+struct seism_core_digest_state
+{
+    uint64_t      v[4];
+    uint64_t      total_len;
+    unsigned char buffer[32];
+    size_t        buffered;
+};
+
+void seism_core_digest_init(seism_core_digest_state* state);
+void seism_core_digest_update(seism_core_digest_state* state, const void* data,
+        size_t len);
+uint64_t seism_core_digest_final(const seism_core_digest_state* state);
+
+#endif
@@ -0,0 +1,203 @@
+// seism-core-element.hh
+#ifndef SEISM_CORE_ELEMENT_HH
+#define SEISM_CORE_ELEMENT_HH
+
+// Element types of the data, in memory and in the file, and conversion
+// between them. Conversions to integers truncate and saturate exactly as
+// HDF5's do. Conversions to half precision round to nearest even as IEEE
+// 754 asks, which HDF5 1.10's soft conversion to a derived half type does
+// not always do (ties, subnormals, overflow): a file written with one
+// converter should be checked with the same.
+
+#include "hdf5.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+enum seism_core_element_type
+{
+    ELEMENT_F32 = 0,    // the default, zero in a cleared configuration
+    ELEMENT_F64,
+    ELEMENT_F16,
+    ELEMENT_I16,
+    ELEMENT_I32,
+    ELEMENT_TYPES
+};
+
+// IEEE half precision, kept as its bits
+struct half_float
+{
+    uint16_t bits;
+};
+
+inline const char* element_type_name(int type)
+{
+    static const char* names[ELEMENT_TYPES] = {"f32", "f64", "f16", "i16", "i32"};
+    return type >= 0 && type < ELEMENT_TYPES ? names[type] : "?";
+}
+
+// -1 if unknown
+inline int element_type_of(const char* name)
+{
+    for (int type = 0; type < ELEMENT_TYPES; type++)
+        if (!strcmp(name, element_type_name(type))) return type;
+    return -1;
+}
+
+inline size_t element_size(int type)
+{
+    static const size_t sizes[ELEMENT_TYPES] = {4, 8, 2, 2, 4};
+    return sizes[type];
+}
+
+// the HDF5 type in memory (native order) or in the file (little endian);
+// always a copy, which the caller closes
+inline hid_t element_hdf5_type(int type, bool in_file)
+{
+    switch (type)
+    {
+        case ELEMENT_F64:
+            return H5Tcopy(in_file ? H5T_IEEE_F64LE : H5T_NATIVE_DOUBLE);
+        case ELEMENT_I16:
+            return H5Tcopy(in_file ? H5T_STD_I16LE : H5T_NATIVE_SHORT);
+        case ELEMENT_I32:
+            return H5Tcopy(in_file ? H5T_STD_I32LE : H5T_NATIVE_INT);
+        case ELEMENT_F16:
+        {
+            // no predefined half type before HDF5 1.14.4; derive one
+            hid_t half = H5Tcopy(in_file ? H5T_IEEE_F32LE : H5T_NATIVE_FLOAT);
+            H5Tset_fields(half, 15, 10, 5, 0, 10);
+            H5Tset_precision(half, 16);
+            H5Tset_size(half, 2);
+            H5Tset_ebias(half, 15);
+            return half;
+        }
+        default:
+            return H5Tcopy(in_file ? H5T_IEEE_F32LE : H5T_NATIVE_FLOAT);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// One element type: to and from double. Integers truncate toward zero and
+// saturate, half precision rounds to nearest even and overflows to infinity.
+
+template<class T> struct element
+{
+    static double to_double(T x) { return x; }
+    static T from_double(double x)
+    {
+        if (x >= (double) std::numeric_limits<T>::max())
+            return std::numeric_limits<T>::max();
+        if (x <= (double) std::numeric_limits<T>::min())
+            return std::numeric_limits<T>::min();
+        return (T) x;
+    }
+};
+
+template<> struct element<float>
+{
+    static double to_double(float x) { return x; }
+    static float from_double(double x) { return (float) x; }
+};
+
+template<> struct element<double>
+{
+    static double to_double(double x) { return x; }
+    static double from_double(double x) { return x; }
+};
+
+inline float half_to_float(uint16_t h)
+{
+    uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff;
+    if (exponent == 0)
+    {
+        // zero or subnormal: mantissa * 2^-24
+        float f = (float) mantissa * 5.9604644775390625e-8f;
+        return sign ? -f : f;
+    }
+    uint32_t bits = exponent == 0x1f
+        ? sign | 0x7f800000 | (mantissa << 13)              // inf, nan
+        : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float f;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+inline uint16_t float_to_half(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    uint16_t sign = (uint16_t) ((bits >> 16) & 0x8000);
+    uint32_t exponent = (bits >> 23) & 0xff, mantissa = bits & 0x7fffff;
+    if (exponent == 0xff)                                   // inf, nan
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    int e = (int) exponent - 112;
+    if (e >= 0x1f) return sign | 0x7c00;                    // overflow
+    if (e <= 0)
+    {
+        // subnormal or zero in half precision
+        if (e < -10) return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - e;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1), tie = 1u << (shift - 1);
+        if (rest > tie || (rest == tie && (half & 1))) half++;
+        return sign | (uint16_t) half;
+    }
+    // round to nearest even; a carry into the exponent is what we want
+    uint32_t half = ((uint32_t) e << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+    return sign | (uint16_t) (half > 0x7c00 ? 0x7c00 : half);
+}
+
+template<> struct element<half_float>
+{
+    static double to_double(half_float x) { return half_to_float(x.bits); }
+    static half_float from_double(double x)
+    {
+        half_float h = {float_to_half((float) x)};
+        return h;
+    }
+};
+
+// n elements from one type to the other; loops the compiler can vectorize
+// for everything but half precision
+template<class From, class To>
+void convert_elements(const From* in, To* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = element<To>::from_double(element<From>::to_double(in[i]));
+}
+
+template<class From>
+void convert_from(const From* in, int to, void* out, size_t n)
+{
+    switch (to)
+    {
+        case ELEMENT_F64: convert_elements(in, (double*) out, n); break;
+        case ELEMENT_F16: convert_elements(in, (half_float*) out, n); break;
+        case ELEMENT_I16: convert_elements(in, (int16_t*) out, n); break;
+        case ELEMENT_I32: convert_elements(in, (int32_t*) out, n); break;
+        default:          convert_elements(in, (float*) out, n); break;
+    }
+}
+
+// n elements of type from at in to type to at out
+inline void convert_elements(int from, const void* in, int to, void* out,
+        size_t n)
+{
+    switch (from)
+    {
+        case ELEMENT_F64: convert_from((const double*) in, to, out, n); break;
+        case ELEMENT_F16: convert_from((const half_float*) in, to, out, n); break;
+        case ELEMENT_I16: convert_from((const int16_t*) in, to, out, n); break;
+        case ELEMENT_I32: convert_from((const int32_t*) in, to, out, n); break;
+        default:          convert_from((const float*) in, to, out, n); break;
+    }
+}
+
+#endif
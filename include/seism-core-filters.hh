@@ -0,0 +1,40 @@
+// seism-core-filters.hh
+#ifndef SEISM_CORE_FILTERS_HH
+#define SEISM_CORE_FILTERS_HH
+
+// Stages of a filter chain, as given to "filter" and stored in the file's
+// attributes: the name, then the parameters, e.g. "zfp rate 16".
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// whether a stage changes the values: scaleoffset, nbit and zfp unless it
+// is reversible
+inline bool is_lossy_filter(const std::string& stage)
+{
+    return !stage.compare(0, 11, "scaleoffset") || !stage.compare(0, 4, "nbit")
+        || (!stage.compare(0, 3, "zfp") && stage.find("reversible") == std::string::npos);
+}
+
+// The filter chain: "deflate" and "zfp" first, as they always were, then the
+// "filter" stages in the order given, separated by ';'. Built the same way
+// from the configuration and from a file's attributes.
+inline std::vector<std::string> filter_stages
+(
+    int         deflate,
+    int         zfp,
+    const char* filters
+)
+{
+    std::vector<std::string> stages;
+    if (deflate) stages.push_back("deflate " + std::to_string(deflate));
+    if (zfp) stages.push_back("zfp");
+    std::string stage;
+    std::istringstream chain(filters ? filters : "");
+    while (std::getline(chain, stage, ';')) 
+        if (!stage.empty()) stages.push_back(stage);
+    return stages;
+}
+
+#endif
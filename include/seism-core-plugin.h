@@ -0,0 +1,72 @@
+/* seism-core-plugin.h
+ *
+ * Block-oriented ABI for fill plugins. A plugin library exports, next to (or
+ * instead of) the per-element function <name>, a descriptor
+ *
+ *     const seism_core_fill_plugin <name>_plugin = {
+ *         SEISM_CORE_PLUGIN_ABI_VERSION, <name>_init, <name>_fill, <name>_finalize
+ *     };
+ *
+ * seism-core looks up <name>_plugin first. If it is present and its
+ * abi_version matches, init() is called once per process, fill() is called
+ * for whole blocks or ranges of rows, and finalize() is called when done.
+ * Otherwise seism-core falls back to calling the per-element function
+ * <name>(mpi_rank, system_size, domain_block_size, domain_block_number,
+ * position_in_block, argc, argv) for every element.
+ *
+ * Version 2 added shared_bytes(). Version 1 descriptors, which end at
+ * finalize, are still accepted.
+ */
+
+#ifndef SEISM_CORE_PLUGIN_H
+#define SEISM_CORE_PLUGIN_H
+
+#include <hdf5.h>
+
+#define SEISM_CORE_PLUGIN_ABI_VERSION     2
+#define SEISM_CORE_PLUGIN_ABI_MIN_VERSION 1
+
+/* Everything a plugin is told about the calling process. The pointers are
+ * only valid during init(); plugins keep whatever they need in their state.
+ *
+ * mpi_rank                 rank of calling process
+ * system_size[3]           number of domain blocks in each direction
+ * domain_block_size[3]     size of domain blocks
+ * domain_block_number[3]   which domain block
+ * argc, argv               plugin-specific arguments (use_function_argv),
+ *                          numbered from zero
+ */
+typedef struct seism_core_fill_args
+{
+    int            mpi_rank;
+    const hsize_t* system_size;
+    const hsize_t* domain_block_size;
+    const hsize_t* domain_block_number;
+    int            argc;
+    char**         argv;
+} seism_core_fill_args;
+
+typedef struct seism_core_fill_plugin
+{
+    /* must be SEISM_CORE_PLUGIN_ABI_VERSION, and stay the first member */
+    int abi_version;
+
+    /* parse arguments and precompute; returns 0 on success */
+    int  (*init)(const seism_core_fill_args* args, void** state);
+
+    /* fill rows [row_begin, row_end) along the first block dimension, i.e.
+     * (row_end - row_begin) * domain_block_size[1] * domain_block_size[2]
+     * floats in C order, starting at buffer */
+    void (*fill)(void* state, hsize_t row_begin, hsize_t row_end,
+                 float* buffer);
+
+    /* release whatever init() acquired */
+    void (*finalize)(void* state);
+
+    /* since version 2, optional: bytes of read-only data this process maps
+     * from memory shared with the other processes on its node, e.g. a file
+     * mapped with mmap(); NULL if there is none */
+    size_t (*shared_bytes)(void* state);
+} seism_core_fill_plugin;
+
+#endif /* SEISM_CORE_PLUGIN_H */
@@ -13,6 +13,7 @@ class SeismCore(CMakePackage):
 
     depends_on("hdf5")
     depends_on("mpi")
+    depends_on("zlib")
 
     variant("plugins", default=False, description="Build plugins to generate other data flavors")
 
@@ -2,6 +2,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <hdf5.h>
+#include "seism-core-plugin.h"
 
 /* Gaussian fill function
  *
@@ -47,3 +48,79 @@ float gaussian(int mpi_rank, hsize_t* system_size, hsize_t* domain_block_size, h
     return A * exp( - ( ((x - x0) * (x - x0)) / (sigma_x * sigma_x) + ((y - y0) * (y - y0)) / (sigma_y * sigma_y) + ((z - z0) * (z - z0)) / (sigma_z * sigma_z) ) );
 }
 
+
+/* Block version of the above, see seism-core-plugin.h
+ *
+ * use_function_name gaussian selects this automatically through
+ * gaussian_plugin. The Gaussian is separable, so init() tabulates one factor
+ * per coordinate along each axis and fill() only multiplies them, in a loop
+ * the compiler can vectorize.
+ */
+
+typedef struct gaussian_state
+{
+    hsize_t domain_block_size[3];
+    float*  factor[3];                /* A is folded into factor[0] */
+} gaussian_state;
+
+static void gaussian_finalize(void* state){
+
+    gaussian_state* g = (gaussian_state*)state;
+    if (!g) return;
+    for (int d = 0; d < 3; d++) free(g->factor[d]);
+    free(g);
+}
+
+static int gaussian_init(const seism_core_fill_args* args, void** state){
+
+    if (args->argc < 4) return -1;
+
+    float A = strtof(args->argv[0], NULL);
+    float sigma[3];
+    sigma[0] = strtof(args->argv[1], NULL);
+    sigma[1] = strtof(args->argv[2], NULL);
+    sigma[2] = strtof(args->argv[3], NULL);
+
+    gaussian_state* g = (gaussian_state*)calloc(1, sizeof(gaussian_state));
+    if (!g) return -1;
+
+    for (int d = 0; d < 3; d++){
+        hsize_t n = args->domain_block_size[d];
+        g->domain_block_size[d] = n;
+        g->factor[d] = (float*)malloc(n * sizeof(float));
+        if (!g->factor[d]){
+            gaussian_finalize(g);
+            return -1;
+        }
+
+        // center the shape in the middle of the block
+        float x0 = 0.5 * args->domain_block_size[d] * args->system_size[d];
+        for (hsize_t i = 0; i < n; i++){
+            float x = args->domain_block_size[d] * args->domain_block_number[d] + i;
+            g->factor[d][i] = exp( - ((x - x0) * (x - x0)) / (sigma[d] * sigma[d]) );
+            if (d == 0) g->factor[d][i] *= A;
+        }
+    }
+
+    *state = g;
+    return 0;
+}
+
+static void gaussian_fill(void* state, hsize_t row_begin, hsize_t row_end, float* buffer){
+
+    const gaussian_state* g = (const gaussian_state*)state;
+    const hsize_t n1 = g->domain_block_size[1];
+    const hsize_t n2 = g->domain_block_size[2];
+    const float* restrict fz = g->factor[2];
+
+    for (hsize_t i = row_begin; i < row_end; i++)
+        for (hsize_t j = 0; j < n1; j++){
+            const float fxy = g->factor[0][i] * g->factor[1][j];
+            float* restrict out = buffer + ((i - row_begin) * n1 + j) * n2;
+            for (hsize_t k = 0; k < n2; k++) out[k] = fxy * fz[k];
+        }
+}
+
+const seism_core_fill_plugin gaussian_plugin = {
+    SEISM_CORE_PLUGIN_ABI_VERSION, gaussian_init, gaussian_fill, gaussian_finalize, NULL
+};
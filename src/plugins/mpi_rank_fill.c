@@ -1,6 +1,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <hdf5.h>
+#include "seism-core-plugin.h"
 
 /* MPI rank fill function
  *
@@ -31,3 +32,38 @@ bool mpi_rank_fill_check(int mpi_rank, hsize_t* system_size, hsize_t* domain_blo
     return false; 
 }
 
+
+/* Block version, selected automatically through mpi_rank_fill_plugin */
+
+typedef struct mpi_rank_fill_state
+{
+    hsize_t row_size;
+    float   value;
+} mpi_rank_fill_state;
+
+static int mpi_rank_fill_init(const seism_core_fill_args* args, void** state){
+
+    mpi_rank_fill_state* m = (mpi_rank_fill_state*)malloc(sizeof(mpi_rank_fill_state));
+    if (!m) return -1;
+    m->row_size = args->domain_block_size[1] * args->domain_block_size[2];
+    m->value = (float)args->mpi_rank;
+    *state = m;
+    return 0;
+}
+
+static void mpi_rank_fill_block(void* state, hsize_t row_begin, hsize_t row_end, float* buffer){
+
+    const mpi_rank_fill_state* m = (const mpi_rank_fill_state*)state;
+    const hsize_t n = (row_end - row_begin) * m->row_size;
+    for (hsize_t i = 0; i < n; i++) buffer[i] = m->value;
+}
+
+static void mpi_rank_fill_finalize(void* state){
+
+    free(state);
+}
+
+const seism_core_fill_plugin mpi_rank_fill_plugin = {
+    SEISM_CORE_PLUGIN_ABI_VERSION, mpi_rank_fill_init, mpi_rank_fill_block, mpi_rank_fill_finalize,
+    NULL
+};
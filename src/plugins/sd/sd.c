@@ -1,7 +1,12 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <hdf5.h>
+#include "seism-core-plugin.h"
 
 /* Fill function using data from UCSD group
  *
@@ -24,39 +29,159 @@
  * OUT: float value from the reference data file
  */
 
-static bool sd_initialized = false;
-static float *buffer;
+/* The reference file is mapped read-only and shared, so every rank on a node
+ * reads the same pages of the page cache: one copy per node rather than one
+ * per rank, and the file is read from the file system once. Where mmap() is
+ * not supported, a private copy is read as before.
+ */
 
-static void initialize_sd(char* filename){
+static bool sd_initialized = false;
+static const float *buffer;
+static size_t buffer_elements;
+static size_t buffer_bytes;
+static bool buffer_mapped;                /* false for a private copy */
+static int sd_references;                 /* init() calls not finalized */
 
-    FILE *fileptr;
-    long filelen;
+static int initialize_sd(const char* filename){
 
-    fileptr = fopen(filename, "rb");      // Open the file in binary mode
-    fseek(fileptr, 0, SEEK_END);          // Jump to the end of the file
-    filelen = ftell(fileptr);             // Get the current byte offset in the file
-    rewind(fileptr);                      // Jump back to the beginning of the file
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(float)){
+        fprintf(stderr, "sd: can't load %s\n", filename);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    buffer_bytes = st.st_size;
+    buffer_elements = buffer_bytes / sizeof(float);
 
-    buffer = (float *)malloc((filelen));  // Enough memory for file 
-    fread(buffer, filelen, 1, fileptr);   // Read in the entire file
-    fclose(fileptr);                      // Close the file
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;                /* read it now, not on first touch */
+#endif
+    void* mapped = mmap(NULL, buffer_bytes, PROT_READ, flags, fd, 0);
+    if (mapped != MAP_FAILED){
+        buffer = (const float *)mapped;
+        buffer_mapped = true;
+    } else {
+        float* copy = (float *)malloc(buffer_bytes);
+        size_t done = 0;
+        while (copy && done < buffer_bytes){
+            ssize_t n = pread(fd, (char *)copy + done, buffer_bytes - done, done);
+            if (n <= 0) break;
+            done += n;
+        }
+        if (!copy || done < buffer_bytes){
+            fprintf(stderr, "sd: can't read %s\n", filename);
+            free(copy);
+            close(fd);
+            return -1;
+        }
+        buffer = copy;
+        buffer_mapped = false;
+    }
+    close(fd);
 
     sd_initialized = true;
+    return 0;
 }
 
 static void close_sd(){
-    free(buffer);
+    if (!sd_initialized) return;
+    if (buffer_mapped) munmap((void *)buffer, buffer_bytes);
+    else free((void *)buffer);
+    buffer = NULL;
+    buffer_elements = buffer_bytes = 0;
+    sd_initialized = false;
+}
+
+/* the block must lie within the reference data */
+static int check_sd_size(const hsize_t* domain_block_size){
+
+    hsize_t needed = domain_block_size[0] * domain_block_size[1] * domain_block_size[2];
+    if (needed <= buffer_elements) return 0;
+    fprintf(stderr, "sd: block of %llu values, but the reference data has only %llu\n",
+            (unsigned long long)needed, (unsigned long long)buffer_elements);
+    return -1;
+}
+
+/* Release hook: whatever is still loaded when the library is unloaded, by the
+ * per-element path, which has no finalize(), or by an init() never finalized.
+ */
+__attribute__((destructor))
+static void sd_release(){
+    close_sd();
+    sd_references = 0;
 }
 
 float sd(int mpi_rank, hsize_t* system_size, hsize_t* domain_block_size, hsize_t* domain_block_number, hsize_t* position_in_block, int argc, char **argv){
 
-    if (!sd_initialized) initialize_sd(argv[0]);
+    if (!sd_initialized){
+        if (argc < 1 || initialize_sd(argv[0]) != 0 || check_sd_size(domain_block_size) != 0)
+            exit(1);
+    }
 
     // map position_in_block and domain_block_size to a position in the data array.
-    unsigned position = position_in_block[2] * domain_block_size[1] * domain_block_size[0]
-                      + position_in_block[1] * domain_block_size[0]
-                      + position_in_block[0];
+    hsize_t position = position_in_block[2] * domain_block_size[1] * domain_block_size[0]
+                     + position_in_block[1] * domain_block_size[0]
+                     + position_in_block[0];
+    if (position >= buffer_elements){
+        fprintf(stderr, "sd: position %llu is outside the reference data\n",
+                (unsigned long long)position);
+        exit(1);
+    }
 
     return buffer[position];
 }
 
+/* Block version, selected automatically through sd_plugin. The reference
+ * data is loaded by the first init() and released by the last finalize(),
+ * and the block is checked against its size once, in init(). It is stored
+ * with the first block index running fastest, so fill() transposes it into
+ * the C order of the write buffer.
+ */
+
+static hsize_t sd_domain_block_size[3];
+
+static int sd_init(const seism_core_fill_args* args, void** state){
+
+    if (args->argc < 1) return -1;
+    if (!sd_initialized && initialize_sd(args->argv[0]) != 0) return -1;
+    if (check_sd_size(args->domain_block_size) != 0){
+        if (sd_references == 0) close_sd();
+        return -1;
+    }
+    for (int d = 0; d < 3; d++) sd_domain_block_size[d] = args->domain_block_size[d];
+    sd_references++;
+    *state = (void *)buffer;
+    return 0;
+}
+
+static void sd_fill(void* state, hsize_t row_begin, hsize_t row_end, float* out){
+
+    const float* data = (const float*)state;
+    const hsize_t n0 = sd_domain_block_size[0];
+    const hsize_t n1 = sd_domain_block_size[1];
+    const hsize_t n2 = sd_domain_block_size[2];
+
+    for (hsize_t i = row_begin; i < row_end; i++)
+        for (hsize_t j = 0; j < n1; j++){
+            float* row = out + ((i - row_begin) * n1 + j) * n2;
+            for (hsize_t k = 0; k < n2; k++) row[k] = data[(k * n1 + j) * n0 + i];
+        }
+}
+
+static void sd_finalize(void* state){
+
+    (void) state;
+    if (sd_references > 0 && --sd_references == 0) close_sd();
+}
+
+static size_t sd_shared_bytes(void* state){
+
+    (void) state;
+    return buffer_mapped ? buffer_bytes : 0;
+}
+
+const seism_core_fill_plugin sd_plugin = {
+    SEISM_CORE_PLUGIN_ABI_VERSION, sd_init, sd_fill, sd_finalize, sd_shared_bytes
+};
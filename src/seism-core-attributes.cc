@@ -62,6 +62,70 @@ void seismCoreAttributes::init()
               use_function_argc), H5T_NATIVE_INT);
     H5Tinsert(attributes_t, "use_function_argv", HOFFSET(seismCoreAttributes, 
               use_function_argv), vls_t);
+
+    // metadata tuning; files written before these were added read back as 0
+    H5Tinsert(attributes_t, "mdc_size", HOFFSET(seismCoreAttributes, 
+              mdc_size), dim3_t);
+    H5Tinsert(attributes_t, "mdc_no_evictions", HOFFSET(seismCoreAttributes, 
+              mdc_no_evictions), H5T_NATIVE_INT);
+    H5Tinsert(attributes_t, "file_space_strategy", HOFFSET(seismCoreAttributes, 
+              file_space_strategy), vls_t);
+    H5Tinsert(attributes_t, "file_space_persist", HOFFSET(seismCoreAttributes, 
+              file_space_persist), H5T_NATIVE_INT);
+    H5Tinsert(attributes_t, "file_space_page_size", HOFFSET(seismCoreAttributes, 
+              file_space_page_size), H5T_NATIVE_ULLONG);
+    H5Tinsert(attributes_t, "page_buffer_size", HOFFSET(seismCoreAttributes, 
+              page_buffer_size), H5T_NATIVE_ULLONG);
+    H5Tinsert(attributes_t, "meta_block_size", HOFFSET(seismCoreAttributes, 
+              meta_block_size), H5T_NATIVE_ULLONG);
+    H5Tinsert(attributes_t, "coll_metadata_write", HOFFSET(seismCoreAttributes, 
+              coll_metadata_write), H5T_NATIVE_INT);
+    H5Tinsert(attributes_t, "evict_on_close", HOFFSET(seismCoreAttributes, 
+              evict_on_close), H5T_NATIVE_INT);
+    H5Tinsert(attributes_t, "filters", HOFFSET(seismCoreAttributes, 
+              filters), vls_t);
+    H5Tinsert(attributes_t, "element_type", HOFFSET(seismCoreAttributes, 
+              element_type), vls_t);
+    H5Tinsert(attributes_t, "memory_type", HOFFSET(seismCoreAttributes, 
+              memory_type), vls_t);
+    H5Tinsert(attributes_t, "type_scale", HOFFSET(seismCoreAttributes, 
+              type_scale), H5T_NATIVE_DOUBLE);
+    H5Tinsert(attributes_t, "own_conversion", HOFFSET(seismCoreAttributes, 
+              own_conversion), H5T_NATIVE_INT);
+    H5Tinsert(attributes_t, "decomposition", HOFFSET(seismCoreAttributes, 
+              decomposition), vls_t);
+    H5Tinsert(attributes_t, "piece_files", HOFFSET(seismCoreAttributes, 
+              piece_files), H5T_NATIVE_INT);
+    H5Tinsert(attributes_t, "subfiling", HOFFSET(seismCoreAttributes, 
+              subfiling), H5T_NATIVE_INT);
+    H5Tinsert(attributes_t, "subfiling_stripe_size", HOFFSET(seismCoreAttributes, 
+              subfiling_stripe_size), H5T_NATIVE_ULLONG);
+    H5Tinsert(attributes_t, "subfiling_ioc", HOFFSET(seismCoreAttributes, 
+              subfiling_ioc), vls_t);
+}
+
+// tuning members default to "not set"
+void seismCoreAttributes::clear_tuning()
+{
+    mdc_size[0] = mdc_size[1] = mdc_size[2] = 0;
+    mdc_no_evictions = 0;
+    file_space_strategy = (char*) "";
+    file_space_persist = 0;
+    file_space_page_size = 0;
+    page_buffer_size = 0;
+    meta_block_size = 0;
+    coll_metadata_write = 0;
+    evict_on_close = 0;
+    filters = (char*) "";
+    element_type = (char*) "f32";
+    memory_type = (char*) "f32";
+    type_scale = 1.0;
+    own_conversion = 0;
+    decomposition = (char*) "";
+    piece_files = 0;
+    subfiling = 0;
+    subfiling_stripe_size = 0;
+    subfiling_ioc = (char*) "";
 }
 
 // the object has been created and initialized before calling this 
@@ -135,6 +199,7 @@ seismCoreAttributes::seismCoreAttributes
     use_function_name = _use_function_name;
     use_function_argc = _use_function_argc;
     use_function_argv = _use_function_argv;
+    clear_tuning();
 
     init();
 }
@@ -145,6 +210,7 @@ seismCoreAttributes::seismCoreAttributes(hid_t file_id)
     herr_t herr_retval = 0;
 
     init();
+    clear_tuning();
 
     // stash the values of attributes_h5t, vls_type_c_id, and dim_h5t
     // before overwriting with values from file
@@ -1,6 +1,28 @@
 // seism-core-check.c /////////////////////////////////////////////////////////
-// 
-// This code checks that seism-core-slice has produced the correct output.  
+//
+// This code checks that seism-core-slice has produced the correct output.
+// The (timestep, block) pairs are dealt out round-robin over the MPI ranks,
+// which read them collectively and compare the values on several threads.
+// usage:
+//
+// mpiexec seism-core-check input-file.h5 [--independent] [--early-exit]
+//                                        [--threads N] [--verbose] [--digest]
+//                                        [--values] [--tolerance T]
+//
+// --independent  read with independent instead of collective I/O
+// --early-exit   stop after the first round in which any rank found an error
+// --threads N    threads per rank comparing values, default is the number of
+//                hardware threads divided by the number of ranks on the node
+// --verbose      print every block as it is checked
+// --digest       compare a digest of every block against the one stored by
+//                seism-core (written with "digest"), instead of comparing
+//                values against the default fill. This is the default for
+//                files written with a fill plugin, unless a filter is lossy.
+// --values       compare values even for files written with a fill plugin,
+//                which is loaded again to regenerate them
+// --tolerance T  count values within T of the original as correct, for
+//                lossy filters; max abs error, RMSE and PSNR are reported
+//                in any case
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -15,168 +37,737 @@
 #include <sstream>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <dlfcn.h>
 
 #include "seism-core-attributes.hh"
+#include "seism-core-digest.hh"
+#include "seism-core-element.hh"
+#include "seism-core-decomposition.hh"
+#include "seism-core-filters.hh"
+#include "seism-core-plugin.h"
 
 using namespace std;
 
 #define CHUNKED_DSET_NAME "chunked"
 
 ///////////////////////////////////////////////////////////////////////////////
-  
+// Compare the elements with the expected ones, expected[i * step], so that a
+// constant is passed with step 0. Counts those within tolerance of it and 
+// sums up the errors. The reductions are declared to the compiler (built with
+// -fopenmp-simd) so that it may reorder them across lanes, and the constant
+// and the array are separate loops so the loads stay contiguous.
+
+struct value_errors
+{
+    unsigned long correct;   // within the tolerance
+    double        max_abs;
+    double        sum_sq;
+};
+
+value_errors compare_values
+(
+    const float* buffer,
+    size_t       n,
+    const float* expected,
+    size_t       step,
+    double       tolerance
+)
+{
+    unsigned long correct = 0;
+    double max_abs = 0.0, sum_sq = 0.0;
+    if (step == 0)
+    {
+        const double value = expected[0];
+        #pragma omp simd reduction(+:correct,sum_sq) reduction(max:max_abs)
+        for (size_t i = 0; i < n; i++)
+        {
+            double error = fabs((double) buffer[i] - value);
+            correct += (error <= tolerance);
+            max_abs = max_abs > error ? max_abs : error;
+            sum_sq += error * error;
+        }
+    }
+    else
+    {
+        #pragma omp simd reduction(+:correct,sum_sq) reduction(max:max_abs)
+        for (size_t i = 0; i < n; i++)
+        {
+            double error = fabs((double) buffer[i] - expected[i]);
+            correct += (error <= tolerance);
+            max_abs = max_abs > error ? max_abs : error;
+            sum_sq += error * error;
+        }
+    }
+    value_errors e = {correct, max_abs, sum_sq};
+    return e;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// compare_values() over n_threads contiguous pieces of the buffer
+
+value_errors check_block
+(
+    const float* buffer,
+    size_t       n,
+    const float* expected,
+    size_t       step,
+    double       tolerance,
+    int          n_threads
+)
+{
+    if (n_threads <= 1) 
+        return compare_values(buffer, n, expected, step, tolerance);
+
+    vector<thread> threads;
+    vector<value_errors> errors(n_threads);
+    size_t piece = (n + n_threads - 1) / n_threads;
+    for (int i = 0; i < n_threads; i++)
+    {
+        size_t begin = min(n, i * piece);
+        size_t end = min(n, begin + piece);
+        threads.push_back(thread([=, &errors]() {
+            errors[i] = compare_values(buffer + begin, end - begin, 
+                    expected + begin * step, step, tolerance);
+        }));
+    }
+    value_errors total = {0, 0.0, 0.0};
+    for (int i = 0; i < n_threads; i++)
+    {
+        threads[i].join();
+        total.correct += errors[i].correct;
+        total.max_abs = max(total.max_abs, errors[i].max_abs);
+        total.sum_sq += errors[i].sum_sq;
+    }
+    return total;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The fill plugin named in the attributes, loaded again to regenerate what
+// it wrote into a block: through the block ABI if it has one, element by 
+// element otherwise, just like seism-core does.
+
+struct fill_reference
+{
+    void*                         handle;
+    const seism_core_fill_plugin* plugin;
+    float (*function)(int, hsize_t*, hsize_t*, hsize_t*, hsize_t*, int, char**);
+    char                          argv_buffer[256];
+    const char*                   argv[16];
+    int                           argc;
+};
+
+bool load_fill_reference(fill_reference& ref, const seismCoreAttributes& attr)
+{
+    ref.handle = dlopen(attr.use_function_lib, RTLD_LAZY);
+    if (!ref.handle) 
+    {
+        cout << dlerror() << endl;
+        return false;
+    }
+
+    // tokenize a copy of the arguments, as seism-core did
+    strncpy(ref.argv_buffer, attr.use_function_argv, 255);
+    ref.argv_buffer[255] = 0;
+    ref.argc = min(attr.use_function_argc, 16);
+    for (int i = 0; i < ref.argc; i++)
+        ref.argv[i] = strtok(i ? NULL : ref.argv_buffer, " ");
+
+    string plugin_name = string(attr.use_function_name) + "_plugin";
+    ref.plugin = (const seism_core_fill_plugin*) 
+        dlsym(ref.handle, plugin_name.c_str());
+    if (ref.plugin && (ref.plugin->abi_version < SEISM_CORE_PLUGIN_ABI_MIN_VERSION
+                || ref.plugin->abi_version > SEISM_CORE_PLUGIN_ABI_VERSION))
+        ref.plugin = NULL;
+    *(void **) (&ref.function) = dlsym(ref.handle, attr.use_function_name);
+    dlerror();
+    return ref.plugin || ref.function;
+}
+
+void fill_block
+(
+    fill_reference&            ref,
+    const seismCoreAttributes& attr,
+    int                        original_rank,
+    hsize_t*                   block_number,
+    hsize_t*                   block_size,
+    float*                     buffer
+)
+{
+    hsize_t* system_size = (hsize_t*) attr.processor_dims;
+    if (ref.plugin)
+    {
+        seism_core_fill_args args = {original_rank, system_size, block_size,
+            block_number, ref.argc, (char **) ref.argv};
+        void* state = NULL;
+        int init_retval = ref.plugin->init(&args, &state);
+        assert(init_retval == 0);
+        ref.plugin->fill(state, 0, block_size[0], buffer);
+        ref.plugin->finalize(state);
+        return;
+    }
+    hsize_t position[3];
+    for (position[0] = 0; position[0] < block_size[0]; position[0]++)
+    for (position[1] = 0; position[1] < block_size[1]; position[1]++)
+    for (position[2] = 0; position[2] < block_size[2]; position[2]++)
+    {
+        hsize_t index = (position[0] * block_size[1] + position[1]) 
+            * block_size[2] + position[2];
+        buffer[index] = ref.function(original_rank, system_size, block_size, 
+                block_number, position, ref.argc, (char **) ref.argv);
+    }
+}
+
+// The values as seism-core wrote them: scaled as floats, converted to the
+// memory type by seism-core, to the file type by seism-core or HDF5, and 
+// read back as floats, by HDF5 like the block being checked
+
+void convert_expected
+(
+    const seismCoreAttributes& attr,
+    int                        memory_type,
+    int                        file_type,
+    vector<float>&             expected
+)
+{
+    size_t n = expected.size();
+    for (size_t i = 0; i < n; i++)
+        expected[i] = (float) (expected[i] * attr.type_scale);
+    // big enough for any element type, H5Tconvert() converts in place
+    vector<char> memory(n * sizeof(double)), file(n * sizeof(double));
+    convert_elements(ELEMENT_F32, &expected[0], memory_type, &memory[0], n);
+    hid_t file_hdf5_type = element_hdf5_type(file_type, false);
+    if (attr.own_conversion)
+        convert_elements(memory_type, &memory[0], file_type, &file[0], n);
+    else
+    {
+        hid_t memory_hdf5_type = element_hdf5_type(memory_type, false);
+        memcpy(&file[0], &memory[0], n * element_size(memory_type));
+        herr_t herr_retval = H5Tconvert(memory_hdf5_type, file_hdf5_type, n, 
+                &file[0], NULL, H5P_DEFAULT);
+        assert(herr_retval >= 0);
+        H5Tclose(memory_hdf5_type);
+    }
+    herr_t herr_retval = H5Tconvert(file_hdf5_type, H5T_NATIVE_FLOAT, n, 
+            &file[0], NULL, H5P_DEFAULT);
+    assert(herr_retval >= 0);
+    H5Tclose(file_hdf5_type);
+    memcpy(&expected[0], &file[0], n * sizeof(float));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int main(int argc, char** argv)
 {
-    if (argc < 2) 
+#ifdef H5_HAVE_SUBFILING_VFD
+    // for the I/O concentrator threads of subfiled files
+    int mpi_thread_provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &mpi_thread_provided);
+#else
+    MPI_Init(&argc, &argv);
+#endif
+    int mpi_rank, mpi_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
+    herr_t herr_retval = (herr_t) 0;
+
+    if (argc < 2)
       {
-        cout << "No filename specified\n" ;
+        if (mpi_rank == 0) cout << "No filename specified\n" ;
+        MPI_Finalize();
         return(1);
       }
     char *filename = argv[1];
 
+    int collective_read = 1;
+    int early_exit = 0;
+    int verbose = 0;
+    int n_threads = 0;
+    int digest = 0;
+    int values = 0;
+    double tolerance = 0.0;
+    for (int i = 2; i<argc; i++)
+    {
+        if (!strcmp(argv[i], "--independent")) collective_read = 0;
+        if (!strcmp(argv[i], "--early-exit")) early_exit = 1;
+        if (!strcmp(argv[i], "--verbose")) verbose = 1;
+        if (!strcmp(argv[i], "--digest")) digest = 1;
+        if (!strcmp(argv[i], "--values")) values = 1;
+        if (!strcmp(argv[i], "--tolerance") && i + 1 < argc)
+            tolerance = atof(argv[++i]);
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            n_threads = atoi(argv[++i]);
+    }
+
+    // by default share the node's hardware threads among its ranks
+    if (n_threads <= 0)
+    {
+        MPI_Comm node_comm;
+        int node_size;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, mpi_rank,
+                MPI_INFO_NULL, &node_comm);
+        MPI_Comm_size(node_comm, &node_size);
+        MPI_Comm_free(&node_comm);
+        n_threads = max(1, (int) thread::hardware_concurrency() / node_size);
+    }
+
     // open file and read the attributes
-    hid_t file = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-    assert(file >= 0);
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    assert(fapl >= 0);
+    herr_retval = H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+    assert(herr_retval >= 0);
+#ifdef H5_HAVE_SUBFILING_VFD
+    // to MPI-IO a subfiled file is a stub without the data; the subfiling 
+    // VFD takes the stripe size and the subfiles from the file
+    hid_t file = H5I_INVALID_HID;
+    H5E_BEGIN_TRY {
+        file = H5Fopen(filename, H5F_ACC_RDONLY, fapl);
+    } H5E_END_TRY;
+    if (file < 0 && mpi_thread_provided < MPI_THREAD_MULTIPLE)
+    {
+        if (mpi_rank == 0) cout << "Can't open " << filename << " with MPI-IO, "
+            "and the subfiling VFD needs MPI_THREAD_MULTIPLE." << endl;
+        MPI_Finalize();
+        return(1);
+    }
+    if (file < 0)
+    {
+        herr_retval = H5Pset_mpi_params(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+        assert(herr_retval >= 0);
+        herr_retval = H5Pset_fapl_subfiling(fapl, NULL);
+        assert(herr_retval >= 0);
+        file = H5Fopen(filename, H5F_ACC_RDONLY, fapl);
+    }
+#else
+    hid_t file = H5Fopen(filename, H5F_ACC_RDONLY, fapl);
+#endif
+    if (file < 0)
+    {
+        if (mpi_rank == 0) cout << "Can't open " << filename << "." << endl;
+        MPI_Finalize();
+        return(1);
+    }
     seismCoreAttributes attr(file);
 
-    cout << endl;
-    cout << "processor dims: ";
-    cout << attr.processor_dims[0] << ":";
-    cout << attr.processor_dims[1] << ":";
-    cout << attr.processor_dims[2] << endl;
-    cout << "chunk dims: ";
-    cout << attr.chunk_dims[0] << ":";
-    cout << attr.chunk_dims[1] << ":";
-    cout << attr.chunk_dims[2] << endl;
-    cout << "domain dims: ";
-    cout << attr.domain_dims[0] << ":";
-    cout << attr.domain_dims[1] << ":";
-    cout << attr.domain_dims[2] << endl;
-    cout << endl;
+    // piece files are read through the virtual dataset, with the file opened
+    // by every rank on its own: parallel HDF5 would open the source files 
+    // collectively whenever a read first touches them
+    if (attr.piece_files)
+    {
+        H5Fclose(file);
+        file = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+        assert(file >= 0);
+        collective_read = 0;
+    }
+
+    // the blocks of an irregular decomposition have their own sizes
+    seism_core_decomposition decomposition;
+    if (!read_decomposition(attr.decomposition, attr.processor_dims, 
+                attr.domain_dims, decomposition))
+    {
+        if (mpi_rank == 0) cout << "The decomposition " << attr.decomposition 
+            << " doesn't match the process grid." << endl;
+        MPI_Finalize();
+        return(1);
+    }
+
+    // lossy filters change the values, so that only a comparison of values
+    // within the tolerance tells how far they are off
+    bool lossy = false, use_zfp = false;
+    vector<string> stages = filter_stages(attr.deflate, attr.zfp, attr.filters);
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        lossy = lossy || is_lossy_filter(stages[i]);
+        use_zfp = use_zfp || !stages[i].compare(0, 3, "zfp");
+    }
+    if (lossy && digest)
+    {
+        if (mpi_rank == 0) cout << "Digests won't match the output of lossy "
+            "filters, comparing values instead." << endl;
+        digest = 0;
+    }
+
+    // files written before the element types were stored read them back as
+    // NULL and 0: floats, unscaled
+    if (!attr.element_type) attr.element_type = (char*) "f32";
+    if (!attr.memory_type) attr.memory_type = (char*) "f32";
+    if (!attr.type_scale) attr.type_scale = 1.0;
+
+    // values scaled, or stored in a type floats don't convert to and from
+    // exactly, are compared with the expected ones converted the same way
+    int file_type = max(element_type_of(attr.element_type), 0);
+    int memory_type = max(element_type_of(attr.memory_type), 0);
+    bool converted = memory_type != ELEMENT_F32 || attr.type_scale != 1.0 ||
+        (file_type != ELEMENT_F32 && file_type != ELEMENT_F64);
+    if (converted && digest)
+    {
+        if (mpi_rank == 0) cout << "Digests are of the values before their "
+            "conversion to " << attr.element_type << ", comparing values "
+            "instead." << endl;
+        digest = 0;
+    }
+
+    // the values written by a plugin are only known to the plugin: compare 
+    // digests, or load it again to compare values
+    bool have_digests = H5Lexists(file, DIGEST_DSET_NAME, H5P_DEFAULT) > 0;
+    bool plugin_fill = attr.use_function_name && attr.use_function_name[0];
+    if (plugin_fill && have_digests && !values && !lossy && !converted)
+        digest = 1;
+    fill_reference reference;
+    if (plugin_fill && !digest && !load_fill_reference(reference, attr))
+    {
+        if (mpi_rank == 0) cout << "Can't load " << attr.use_function_name 
+            << " from " << attr.use_function_lib << " to compare values." << endl;
+        MPI_Finalize();
+        return(1);
+    }
+    if (digest && !have_digests)
+    {
+        if (mpi_rank == 0) cout << filename << " has no " << DIGEST_DSET_NAME
+            << " dataset, write it with the digest option." << endl;
+        MPI_Finalize();
+        return(1);
+    }
+
+    if (mpi_rank == 0)
+    {
+        cout << endl;
+        cout << "processor dims: ";
+        cout << attr.processor_dims[0] << ":";
+        cout << attr.processor_dims[1] << ":";
+        cout << attr.processor_dims[2] << endl;
+        cout << "chunk dims: ";
+        cout << attr.chunk_dims[0] << ":";
+        cout << attr.chunk_dims[1] << ":";
+        cout << attr.chunk_dims[2] << endl;
+        cout << "domain dims: ";
+        cout << attr.domain_dims[0] << ":";
+        cout << attr.domain_dims[1] << ":";
+        cout << attr.domain_dims[2] << endl;
+        if (attr.decomposition && attr.decomposition[0])
+            cout << "decomposition: " << attr.decomposition << endl;
+        if (attr.piece_files)
+            cout << "piece files: " << attr.piece_files 
+                 << " (read through the virtual dataset)" << endl;
+        if (attr.subfiling)
+        {
+            cout << "subfiling VFD: stripe size ";
+            if (attr.subfiling_stripe_size) cout << attr.subfiling_stripe_size;
+            else cout << "default";
+            cout << ", I/O concentrators ";
+            if (attr.subfiling_ioc && attr.subfiling_ioc[0]) 
+                cout << attr.subfiling_ioc << endl;
+            else cout << "default" << endl;
+        }
+        cout << "element types: " << element_type_name(memory_type) << " -> " 
+             << element_type_name(file_type);
+        if (attr.type_scale != 1.0) cout << ", scaled by " << attr.type_scale;
+        if (file_type != memory_type)
+            cout << (attr.own_conversion ? " (seism-core)" : " (HDF5)");
+        cout << endl;
+        cout << "checking ranks: " << mpi_size << " x " << n_threads
+             << " threads" << endl;
+        cout << "collective read: " << collective_read << endl;
+        cout << "early exit: " << early_exit << endl;
+        cout << "check: " << (digest ? "block digests (" DIGEST_ALGORITHM ")" 
+                : (plugin_fill ? "values (regenerated)" : "values")) << endl;
+        if (!digest) cout << "tolerance: " << tolerance << endl;
+        cout << endl;
+    }
 
 #ifdef INCLUDE_ZFP
-    if (zfp != 0) assert(H5Z_zfp_initialize() >= 0);
+    if (use_zfp)
+    {
+        herr_retval = H5Z_zfp_initialize();
+        assert(herr_retval >= 0);
+    }
 #endif
 
     // open the dataset
     hid_t dset = H5Dopen (file, CHUNKED_DSET_NAME, H5P_DEFAULT);
+    assert(dset >= 0);
+
+    hid_t dxpl = H5Pcreate(H5P_DATASET_XFER);
+    assert(dxpl >= 0);
+    if (collective_read)
+    {
+        herr_retval = H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+        assert(herr_retval >= 0);
+    }
 
-    // create a buffer to hold one domain worth of data
-    hsize_t domain_size = 
-        attr.domain_dims[0] * attr.domain_dims[1] * attr.domain_dims[2];
-    float *buffer = 
+    // the file and memory dataspaces are reused for every block, the memory
+    // one resized to it
+    hid_t fspace = H5Dget_space(dset);
+    assert(fspace >= 0);
+    hsize_t stride[4] = {1,1,1,1};
+    hsize_t count[4] = {1,1,1,1};
+    hsize_t block[4] = {1, 0, 0, 0};
+    for (int d = 0; d < 3; d++)
+        block[d + 1] = *max_element(decomposition.sizes[d].begin(), 
+                decomposition.sizes[d].end());
+    hid_t mspace = H5Screate_simple(4, block, NULL);
+    assert (mspace >= 0);
+
+    // create a buffer to hold the largest block
+    hsize_t domain_size = block[1] * block[2] * block[3];
+    float *buffer =
         (float *)malloc(sizeof(float) * domain_size);
+    vector<float> expected((plugin_fill || converted) && !digest ? 
+            domain_size : 0);
+
+    // errors of the values, and the range of the originals for the PSNR
+    double max_abs_error = 0.0, sum_sq_error = 0.0;
+    double value_range[2] = {-HUGE_VAL, -HUGE_VAL}; // -min, max
 
     unsigned long found_correct = 0;
     unsigned long found_incorrect = 0;
+    unsigned long elements_read = 0;
+
+    // the stored digests are small, every rank reads all of them
+    unsigned long n_digests = attr.simulation_time
+        * attr.processor_dims[0] * attr.processor_dims[1] * attr.processor_dims[2];
+    vector<uint64_t> stored_digests(digest ? n_digests : 0);
+    if (digest)
+    {
+        hid_t digest_dset = H5Dopen(file, DIGEST_DSET_NAME, H5P_DEFAULT);
+        assert(digest_dset >= 0);
+        herr_retval = H5Dread(digest_dset, H5T_NATIVE_UINT64, H5S_ALL, H5S_ALL,
+                H5P_DEFAULT, &stored_digests[0]);
+        assert(herr_retval >= 0);
+        H5Dclose(digest_dset);
+    }
+
+    // every rank takes part in every round so the reads can be collective;
+    // ranks without a block in the last round read an empty selection
+    unsigned long n_blocks =
+        attr.processor_dims[0] * attr.processor_dims[1] * attr.processor_dims[2];
+    unsigned long n_items = n_blocks * attr.simulation_time;
+    unsigned long n_rounds = (n_items + mpi_size - 1) / mpi_size;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double begin_check = MPI_Wtime();
+    double read_time = 0.0;
+    unsigned long rounds_done = 0;
+
+    for (unsigned long round = 0; round < n_rounds; round++)
+    {
+        unsigned long item = round * mpi_size + mpi_rank;
+        bool have_item = item < n_items;
 
-    // loop over time and processor geom
-    for (unsigned int t=0; t<attr.simulation_time; t++) 
-    for (
-            unsigned int processor_i=0; 
-            processor_i<attr.processor_dims[0]; 
-            processor_i++
-        )
-            for 
-            (
-                unsigned int processor_j=0; 
-                processor_j<attr.processor_dims[1]; 
-                processor_j++
-            )
-                for 
-                (
-                    unsigned int processor_k=0;
-                    processor_k<attr.processor_dims[2];
-                    processor_k++
-                )
+        unsigned int t = 0;
+        unsigned int processor_i = 0, processor_j = 0, processor_k = 0;
+        hsize_t block_size = 0;
+        if (have_item)
+        {
+            t = item / n_blocks;
+            unsigned long original = item % n_blocks;
+            processor_k = original % attr.processor_dims[2];
+            processor_j = (original / attr.processor_dims[2])
+                % attr.processor_dims[1];
+            processor_i = original / (attr.processor_dims[2]
+                * attr.processor_dims[1]);
+
+            hsize_t block_number[3] = {processor_i, processor_j, processor_k};
+            hsize_t start[4] = {t, 0, 0, 0};
+            decomposition_block(decomposition, block_number, start + 1, 
+                    block + 1);
+            block_size = block[1] * block[2] * block[3];
+
+            // select hyperslab within file dataspace
+            herr_retval = H5Sselect_hyperslab(
+                fspace, H5S_SELECT_SET, start, stride, count, block );
+            assert(herr_retval >= 0);
+            herr_retval = H5Sset_extent_simple(mspace, 4, block, NULL);
+            assert(herr_retval >= 0);
+            herr_retval = H5Sselect_all(mspace);
+            assert(herr_retval >= 0);
+        }
+        else
+        {
+            herr_retval = H5Sselect_none(fspace);
+            assert(herr_retval >= 0);
+            herr_retval = H5Sselect_none(mspace);
+            assert(herr_retval >= 0);
+        }
+
+        // read the dataset into the buffer
+        double begin_read = MPI_Wtime();
+        herr_retval = H5Dread (dset, H5T_NATIVE_FLOAT, mspace, fspace,
+                dxpl, buffer);
+        assert(herr_retval >= 0);
+        read_time += MPI_Wtime() - begin_read;
+        if (have_item) elements_read += block_size;
+
+        unsigned long local_errors = 0;
+        if (have_item)
+        {
+            float original_mpi_rank =
+                processor_i * attr.processor_dims[1]
+                * attr.processor_dims[2]
+                + processor_j * attr.processor_dims[2]
+                + processor_k;
+            if (verbose)
+                cout << "checking time step #" << t << " / processor @ ( "
+                     << processor_i << ", " << processor_j << ", "
+                     << processor_k << " )" << " with original rank #"
+                     << original_mpi_rank << endl;
+
+            if (digest)
+            {
+                // counts are in blocks rather than elements here
+                uint64_t read_digest = 
+                    seism_core_digest(buffer, block_size * sizeof(float));
+                if (read_digest == stored_digests[item]) found_correct++;
+                else
+                {
+                    cout << "Digest mismatch in time step #" << t 
+                         << " / processor @ ( " << processor_i << ", "
+                         << processor_j << ", " << processor_k << " ): "
+                         << hex << read_digest << " != " 
+                         << stored_digests[item] << dec << endl;
+                    local_errors = 1;
+                    found_incorrect++;
+                }
+            }
+            else
+            {
+                // the default fill is the original rank everywhere
+                const float* reference_values = &original_mpi_rank;
+                size_t step = 0;
+                expected.resize(expected.empty() ? 0 : block_size);
+                if (plugin_fill)
+                {
+                    hsize_t block_number[3] = 
+                        {processor_i, processor_j, processor_k};
+                    fill_block(reference, attr, (int) original_mpi_rank, 
+                            block_number, block + 1, &expected[0]);
+                    reference_values = &expected[0];
+                    step = 1;
+                }
+                if (converted)
+                {
+                    if (!plugin_fill) 
+                        fill(expected.begin(), expected.end(), original_mpi_rank);
+                    convert_expected(attr, memory_type, file_type, expected);
+                    reference_values = &expected[0];
+                    step = 1;
+                }
+                value_errors errors = check_block(buffer, block_size, 
+                        reference_values, step, tolerance, n_threads);
+                found_correct += errors.correct;
+                local_errors = block_size - errors.correct;
+                max_abs_error = max(max_abs_error, errors.max_abs);
+                sum_sq_error += errors.sum_sq;
+                for (size_t i = 0; i < (step ? block_size : 1); i++)
+                {
+                    value_range[0] = max(value_range[0], (double) -reference_values[i]);
+                    value_range[1] = max(value_range[1], (double) reference_values[i]);
+                }
+
+                if (local_errors)
                 {
-                    float original_mpi_rank = 
-                        processor_i * attr.processor_dims[1] 
-                        * attr.processor_dims[2] 
-                        + processor_j * attr.processor_dims[2] 
-                        + processor_k;
-                    cout << "checking time step #" << t << " / processor @ ( " 
-                         << processor_i << ", " << processor_j << ", " 
-                         << processor_k << " )" << " with original rank #" 
-                         << original_mpi_rank << endl;
-
-                    // get the dataspace
-                    hid_t fspace = H5Dget_space(dset);
-                    hsize_t start[4] = {t, 
-                        processor_i * attr.domain_dims[0], 
-                        processor_j * attr.domain_dims[1],
-                        processor_k * attr.domain_dims[2]};
-                    hsize_t stride[4] = {1,1,1,1};
-                    hsize_t count[4] = {1,1,1,1};
-                    hsize_t block[4] = {1,
-                        attr.domain_dims[0],
-                        attr.domain_dims[1],
-                        attr.domain_dims[2]};
-
-                    // select hyperslab within file dataspace
-                    assert ( H5Sselect_hyperslab(
-                        fspace, H5S_SELECT_SET, start, stride, count, block ) 
-                        >= 0 );
-
-                    hid_t mspace = H5Screate_simple(4, block, NULL);
-                    assert (mspace >= 0);
-                    assert (H5Sselect_all(mspace) >= 0);
-
-                    // read the dataset into the buffer
-                    assert( H5Dread (dset, H5T_NATIVE_FLOAT, mspace, fspace, 
-                            H5P_DEFAULT, buffer) >= 0);
-                    
-                    unsigned long local_errors = 0;
-                    // loop over elements in buffer, check value
-                    for 
-                    (
-                        unsigned int domain_i=0;
-                        domain_i<attr.domain_dims[0]; 
-                        domain_i++
-                    )
-                        for 
-                        (
-                            unsigned int domain_j=0; 
-                            domain_j<attr.domain_dims[1]; 
-                            domain_j++
-                        )
-                            for 
-                            (
-                                unsigned int domain_k=0; 
-                                domain_k<attr.domain_dims[2]; 
-                                domain_k++
-                            )
-                            {
-                                unsigned int buffer_element = 
-                                    domain_i * attr.domain_dims[1] 
-                                    * attr.domain_dims[2] 
-                                    + domain_j * attr.domain_dims[2] 
-                                    + domain_k ;
-                                if (buffer[buffer_element] 
-                                        == original_mpi_rank) found_correct++;
-                                else local_errors++;
-                            }
-                            if (local_errors)
-                            {
-                                cout << "Found " << local_errors << " errors."
-                                     << endl;
-                                found_incorrect += local_errors;
-                            }
-
-                    H5Sclose(fspace);
-                    H5Sclose(mspace);
-
-                } // end loop over k, j, i, t
-
-    cout << endl;
-    cout << "Checking complete. Found totals of: " << found_correct 
-         << " correct / " << found_incorrect << " incorrect." << endl;
-    cout << endl;
+                    // find the first one again, serially, for the report
+                    size_t first = 0;
+                    while (fabs((double) buffer[first] - 
+                                reference_values[first * step]) <= tolerance) 
+                        first++;
+                    cout << "Found " << local_errors << " errors in time step #"
+                         << t << " / processor @ ( " << processor_i << ", "
+                         << processor_j << ", " << processor_k << " ), first at"
+                         << " element " << first << ": " << buffer[first]
+                         << " != " << reference_values[first * step] << endl;
+                    found_incorrect += local_errors;
+                }
+            }
+        }
+        rounds_done++;
+
+        if (early_exit)
+        {
+            unsigned long any_errors = 0;
+            MPI_Allreduce(&local_errors, &any_errors, 1, MPI_UNSIGNED_LONG,
+                    MPI_MAX, MPI_COMM_WORLD);
+            if (any_errors) break;
+        }
+    }
+
+    double check_time = MPI_Wtime() - begin_check;
+
+    unsigned long total_correct = 0, total_incorrect = 0, total_read = 0;
+    MPI_Reduce(&found_correct, &total_correct, 1, MPI_UNSIGNED_LONG,
+            MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&found_incorrect, &total_incorrect, 1, MPI_UNSIGNED_LONG,
+            MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&elements_read, &total_read, 1, MPI_UNSIGNED_LONG,
+            MPI_SUM, 0, MPI_COMM_WORLD);
+    double total_max_abs_error = 0.0, total_sum_sq_error = 0.0;
+    double total_value_range[2] = {0.0, 0.0};
+    MPI_Reduce(&max_abs_error, &total_max_abs_error, 1, MPI_DOUBLE, MPI_MAX,
+            0, MPI_COMM_WORLD);
+    MPI_Reduce(&sum_sq_error, &total_sum_sq_error, 1, MPI_DOUBLE, MPI_SUM,
+            0, MPI_COMM_WORLD);
+    MPI_Reduce(value_range, total_value_range, 2, MPI_DOUBLE, MPI_MAX,
+            0, MPI_COMM_WORLD);
+    double max_read_time = 0.0, max_check_time = 0.0;
+    MPI_Reduce(&read_time, &max_read_time, 1, MPI_DOUBLE, MPI_MAX, 0,
+            MPI_COMM_WORLD);
+    MPI_Reduce(&check_time, &max_check_time, 1, MPI_DOUBLE, MPI_MAX, 0,
+            MPI_COMM_WORLD);
+
+    if (mpi_rank == 0)
+    {
+        double bytes_read = sizeof(float) * (double) total_read;
+        cout << endl;
+        if (rounds_done < n_rounds)
+            cout << "Stopped early after " << rounds_done << " of "
+                 << n_rounds << " rounds." << endl;
+        cout << "Checking complete. Found totals of: " << total_correct
+             << " correct / " << total_incorrect << " incorrect"
+             << (digest ? " blocks." : ".") << endl;
+        if (!digest && total_read)
+        {
+            // PSNR against the range of the original values
+            double rmse = sqrt(total_sum_sq_error / total_read);
+            double peak = total_value_range[0] + total_value_range[1];
+            cout << "Max abs error: " << total_max_abs_error << ", RMSE: " 
+                 << rmse << ", PSNR: ";
+            if (rmse == 0.0) cout << "inf" << endl;
+            else if (peak > 0.0) cout << 20.0 * log10(peak / rmse) << " dB" << endl;
+            else cout << "n/a (constant data)" << endl;
+        }
+        cout << "Read time: " << max_read_time << " s, "
+             << bytes_read / max_read_time / ((double) (1<<20)) << " MB/s"
+             << endl;
+        cout << "Check time: " << max_check_time << " s, "
+             << bytes_read / max_check_time / ((double) (1<<20)) << " MB/s"
+             << endl;
+        cout << endl;
+    }
 
+    free(buffer);
+    if (plugin_fill && !digest) dlclose(reference.handle);
+    attr.finalize();
+    H5Sclose(fspace);
+    H5Sclose(mspace);
+    H5Pclose(dxpl);
     H5Dclose(dset);
     H5Fclose(file);
+    H5Pclose(fapl);
 
 #ifdef INCLUDE_ZFP
-    if (zfp != 0) assert(H5Z_zfp_finalize() >= 0);
+    if (use_zfp)
+    {
+        herr_retval = H5Z_zfp_finalize();
+        assert(herr_retval >= 0);
+    }
 #endif
-}
 
+    // every rank exits with the same status, whichever the launcher reports
+    MPI_Bcast(&total_incorrect, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+
+    MPI_Finalize();
+
+    return (total_incorrect == 0) ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// seism-core-digest.cc
+//
+// XXH64, see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+// Fast enough to digest every block while it is written, and to verify 
+// blocks on read-back at I/O speed.
+
+#include "seism-core-digest.hh"
+#include <cstring>
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// unaligned little-endian loads
+static inline uint64_t read64(const unsigned char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t merge_round64(uint64_t acc, uint64_t val)
+{
+    acc ^= round64(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// the four lanes merged, for inputs of at least 32 bytes
+static inline uint64_t merge_lanes(const uint64_t* v)
+{
+    uint64_t h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + 
+        rotl64(v[3], 18);
+    for (int i = 0; i < 4; i++) h = merge_round64(h, v[i]);
+    return h;
+}
+
+// the remaining bytes, less than 32, and the avalanche
+static uint64_t finish64(uint64_t h, const unsigned char* p, 
+        const unsigned char* end)
+{
+    while (p + 8 <= end)
+    {
+        h ^= round64(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= (uint64_t) read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end)
+    {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    // avalanche
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+// consume whole 32-byte stripes from p, returns where it stopped
+static inline const unsigned char* stripes(uint64_t* v, const unsigned char* p,
+        const unsigned char* end)
+{
+    while (p + 32 <= end)
+    {
+        v[0] = round64(v[0], read64(p));
+        v[1] = round64(v[1], read64(p + 8));
+        v[2] = round64(v[2], read64(p + 16));
+        v[3] = round64(v[3], read64(p + 24));
+        p += 32;
+    }
+    return p;
+}
+
+static inline void init_lanes(uint64_t* v)
+{
+    v[0] = PRIME64_1 + PRIME64_2;
+    v[1] = PRIME64_2;
+    v[2] = 0;
+    v[3] = 0 - PRIME64_1;
+}
+
+uint64_t seism_core_digest(const void* data, size_t len)
+{
+    const unsigned char* p = (const unsigned char*) data;
+    const unsigned char* end = p + len;
+    uint64_t h;
+
+    if (len >= 32)
+    {
+        // four independent lanes over 32-byte stripes
+        uint64_t v[4];
+        init_lanes(v);
+        p = stripes(v, p, end);
+        h = merge_lanes(v);
+    }
+    else
+    {
+        h = PRIME64_5;
+    }
+
+    h += (uint64_t) len;
+    return finish64(h, p, end);
+}
+
+void seism_core_digest_init(seism_core_digest_state* state)
+{
+    init_lanes(state->v);
+    state->total_len = 0;
+    state->buffered = 0;
+}
+
+void seism_core_digest_update(seism_core_digest_state* state, const void* data,
+        size_t len)
+{
+    const unsigned char* p = (const unsigned char*) data;
+    const unsigned char* end = p + len;
+    state->total_len += len;
+
+    // complete a stripe left over from the last update first
+    if (state->buffered)
+    {
+        size_t n = 32 - state->buffered;
+        if (n > len) n = len;
+        memcpy(state->buffer + state->buffered, p, n);
+        state->buffered += n;
+        p += n;
+        if (state->buffered < 32) return;
+        stripes(state->v, state->buffer, state->buffer + 32);
+        state->buffered = 0;
+    }
+    p = stripes(state->v, p, end);
+    memcpy(state->buffer, p, end - p);
+    state->buffered = end - p;
+}
+
+uint64_t seism_core_digest_final(const seism_core_digest_state* state)
+{
+    uint64_t h = (state->total_len >= 32) ? merge_lanes(state->v) : PRIME64_5;
+    h += state->total_len;
+    return finish64(h, state->buffer, state->buffer + state->buffered);
+}
@@ -24,6 +24,79 @@
 // DONE
 // EOF
 //
+// To measure how much of the checkpoint cost can be hidden behind simulation
+// work, add "compute_time <seconds>" to emulate a compute phase before each
+// timestep, and "async_write" to overlap the write of step N with the
+// compute phase of step N+1.
+//
+// Several configurations can be run in one job: end each block with NEXT
+// instead of DONE, and/or give numeric arguments as lists or ranges, e.g.
+// "chunk 90,180 128 128", "deflate 0:9:3" or "collective_write 0,1".
+//
+// With "digest", every rank also stores a digest of its block for every 
+// timestep, so that seism-core-check can verify data from any fill.
+//
+// With "io_servers <n>", n extra ranks write on behalf of all the others,
+// which send them their blocks and carry on computing.
+//
+// With "node_aggregate", the ranks of a node gather their blocks in shared
+// memory and one rank per node writes them.
+//
+// "variables <n>" writes n datasets per timestep instead of one, with 
+// "multi_dataset" in a single H5Dwrite_multi() call (HDF5 1.14+).
+//
+// "extend_time" starts with an empty, unlimited time dimension and extends
+// the datasets by one timestep before each is written.
+//
+// Metadata cache, file space and page buffer settings can be tuned with
+// mdc_size, mdc_no_evictions, file_space_strategy, file_space_persist,
+// file_space_page_size, page_buffer_size, meta_block_size, 
+// coll_metadata_write and evict_on_close.
+//
+// Stripe settings are passed to MPI-IO as striping_factor/striping_unit
+// hints, and chunks are aligned to the stripe size, or to "align <bytes>".
+//
+// "direct_chunk <threads>" deflates the chunks on a thread pool and writes
+// them with H5Dwrite_chunk(), bypassing the filter pipeline. With deflate
+// every file needs a single writer; zfp and filters stay in the pipeline.
+//
+// "filter <name> [parameters]" adds a stage to the filter chain, e.g.
+// "filter shuffle", "filter zfp rate 16" or "filter scaleoffset 3". The
+// chain is also measured in memory, with the error of lossy stages.
+//
+// "memory_budget <bytes>" streams each timestep through a buffer of that
+// size, generating and writing the block one slab of rows at a time.
+//
+// Fill plugins may map read-only data shared on the node (see the sd plugin);
+// the time in their init() and the memory saved are reported.
+//
+// "results_file <file>" appends every case to a JSON lines results store,
+// and "compare_results <file>" tests it for a slowdown against earlier runs
+// of the same configuration there.
+//
+// "scaling weak" or "scaling strong" runs the case on 1, 2, 4, ... ranks of
+// the job and reports the scaling efficiency.
+//
+// "file_type" and "memory_type" set the element types, f32, f64, f16, i16
+// or i32, and "own_conversion" converts between them here rather than in
+// H5Dwrite(); both conversions are measured against each other.
+//
+// "halo <width>" keeps the block inside an array padded with halo cells and
+// writes its interior, selected in memory or, with "halo_pack", packed into
+// a contiguous buffer first.
+//
+// "split <axis> <sizes>" and "imbalance <ratio>" decompose the domain into
+// blocks of different sizes; the bytes and write time per rank and the
+// chunks shared by blocks are reported.
+//
+// "file_groups <n>", "file_groups process" or "file_groups node" writes a
+// file per group of ranks, and the output file maps them with virtual 
+// datasets; reading through those is measured against reading the pieces.
+//
+// "subfiling" writes through the subfiling VFD of HDF5 1.14+ instead, with
+// "subfiling_stripe_size <bytes>" and "subfiling_ioc node|nth|total <n>"
+// choosing the stripes and the I/O concentrators.
+//
 //////////////////////////////////////////////////////////////////////////////
 
 #include "hdf5.h"
@@ -39,8 +112,24 @@
 #include <vector>
 #include <dlfcn.h>
 #include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <atomic>
+#include <zlib.h>
+#include <cmath>
+#include <ctime>
+#include <glob.h>
+#include <sys/stat.h>
 
 #include "seism-core-attributes.hh"
+#include "seism-core-plugin.h"
+#include "seism-core-digest.hh"
+#include "seism-core-element.hh"
+#include "seism-core-decomposition.hh"
+#include "seism-core-filters.hh"
 
 using namespace std;
 
@@ -62,6 +151,28 @@ herr_t H5Pget_all_coll_metadata_ops(hid_t dapl, hbool_t *actual_metadata_ops_col
 
 #endif
 
+#if ! H5_VERSION_GE(1,10,3)
+
+herr_t H5Dwrite_chunk(hid_t dset, hid_t dxpl, uint32_t filters, 
+        const hsize_t* offset, size_t data_size, const void* buf)
+{
+    cout << "direct_chunk option only available with HDF5 version 1.10.3+\n" << endl;
+    return -1;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+  
+// name of the dataset of simulation variable i; the first one is the one
+// seism-read and seism-core-check look at
+
+string variable_dset_name(int i)
+{
+    if (i == 0) return CHUNKED_DSET_NAME;
+    return string(CHUNKED_DSET_NAME) + "_" + to_string(i);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
   
 void precreate_0
@@ -69,27 +180,27 @@ void precreate_0
 //    const string& filename,
     const char*   filename,
     hid_t         fspace,
-    hid_t         dcpl
+    hid_t         dcpl,
+    int           variables,
+    hid_t         fcpl,
+    hid_t         fapl,        // serial, tuned like the parallel one
+    hid_t         file_type
 )
 {
     herr_t herr_retval = (herr_t) 0;
 
-    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
-    assert(fapl >= 0);
-    herr_retval = H5Pset_libver_bounds(fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
-    assert(herr_retval >= 0);
-
-    hid_t file = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    hid_t file = H5Fcreate(filename, H5F_ACC_TRUNC, fcpl, fapl);
     assert(file >= 0);
-    hid_t dset = H5Dcreate(file, CHUNKED_DSET_NAME, H5T_IEEE_F32LE, fspace,
-                           H5P_DEFAULT, dcpl, H5P_DEFAULT);
-    assert(dset >= 0);
-    herr_retval = H5Dclose(dset);
-    assert(herr_retval >= 0);
+    for (int i = 0; i < variables; i++)
+    {
+        hid_t dset = H5Dcreate(file, variable_dset_name(i).c_str(), file_type, 
+                               fspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+        assert(dset >= 0);
+        herr_retval = H5Dclose(dset);
+        assert(herr_retval >= 0);
+    }
     herr_retval = H5Fclose(file);
     assert(herr_retval >= 0);
-    herr_retval = H5Pclose(fapl);
-    assert(herr_retval >= 0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -111,496 +222,4361 @@ void setMPI_Info(MPI_Info& info, const size_t& v_size, int mpi_size)
 }
 
 ///////////////////////////////////////////////////////////////////////////////
+// Striping of a file created through MPI-IO, e.g. by ROMIO's Lustre driver.
+// Hints the file system doesn't know are ignored.
 
-int main(int argc, char** argv)
+void setStriping_Info(MPI_Info& info, unsigned stripe_count, unsigned stripe_size)
 {
-    herr_t herr_retval = (herr_t) 0;
     int mpi_retval = 0;
-    int mpi_size, mpi_rank;
-
-    MPI_Init(&argc, &argv);
-    double begin = MPI_Wtime();
-    MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
-    MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
-
-    // rank 0 reads the input file, then broadcasts
-    char filename[256];
-    strcpy(filename,  "seism-test.h5");
-    string parameter, rest_of_line;
-    unsigned int simulation_time;
-    hsize_t processor[3], chunk[3], domain[3];
-    int collective_write = 0;
-    int precreate = 0;
-    int set_collective_metadata = 0;
-    int never_fill = 0;
-    int deflate = 0;
-    int subfile = 0;
-    int n_nodes = 0;
-    unsigned lfs_stripe_count = 0;
-    unsigned lfs_stripe_size = 0;
-    char use_function_lib[256];
-    use_function_lib[0] = 0; // truncate any junk string in auto var
-    char use_function_name[256];
-    use_function_name[0] = 0; // if no param passed, then strcmp test will fail
-    int use_function_argc = 0;
-    string use_function_argv_string;
-    char use_function_argv[256];
-    use_function_argv[0] = 0; // truncate any junk string in auto var
-    int zfp = 0;
-    const char *use_function_argv_c_str = NULL;
-
-    if (mpi_rank==0)
+    if (stripe_count)
     {
-        while (true)
-        {
-            cin >> parameter;
-            if (parameter.at(0) == '#') continue; // ignore as comment
-            if (parameter.at(0) == 0) continue; // ignore empty line
-            if (!parameter.compare("DONE")) break; // exit
-            if (!parameter.compare("processor"))
-              cin >> processor[0] >> processor[1] >> processor[2];
-            if (!parameter.compare("chunk"))
-              cin >> chunk[0] >> chunk[1] >> chunk[2];
-            if (!parameter.compare("domain"))
-              cin >> domain[0] >> domain[1] >> domain[2];
-            if (!parameter.compare("time"))
-              cin >> simulation_time;
-            if (!parameter.compare("collective_write"))
-              collective_write = true;
-            if (!parameter.compare("precreate"))
-              precreate = true;
-            if (!parameter.compare("set_collective_metadata"))
-              set_collective_metadata = true;
-            if (!parameter.compare("never_fill"))
-              never_fill = true;
-            if (!parameter.compare("deflate"))
-              cin >> deflate;
-            if (!parameter.compare("subfile"))
-              cin >> subfile;
-            if (!parameter.compare("n_nodes"))
-              cin >> n_nodes;
-            if (!parameter.compare("lfs_stripe_count"))
-              cin >> lfs_stripe_count;
-            if (!parameter.compare("lfs_stripe_size"))
-              cin >> lfs_stripe_size;
-            if (!parameter.compare("filename"))
-              cin >> filename;
-            if (!parameter.compare("use_function_lib"))
-              cin >> use_function_lib;
-            if (!parameter.compare("use_function_name"))
-              cin >> use_function_name;
-            if (!parameter.compare("use_function_argc"))
-              cin >> use_function_argc;
-            if (!parameter.compare("use_function_argv"))
-            {
-                // read the rest of the line
-                getline(cin, use_function_argv_string);
-                // extract a C-string to pass via MPI
-                use_function_argv_c_str = use_function_argv_string.c_str(); 
-                strcpy(use_function_argv, use_function_argv_c_str);
-                continue;
-            }
-            if (!parameter.compare("zfp"))
-              cin >> zfp;
-            getline(cin, rest_of_line); // read the rest of the line
-        }
+        mpi_retval = MPI_Info_set( info, "striping_factor", 
+                to_string(stripe_count).c_str() );
+        assert(mpi_retval == MPI_SUCCESS);
     }
+    if (stripe_size)
+    {
+        mpi_retval = MPI_Info_set( info, "striping_unit", 
+                to_string(stripe_size).c_str() );
+        assert(mpi_retval == MPI_SUCCESS);
+    }
+}
 
-    mpi_retval = MPI_Bcast(&simulation_time, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&processor, 3, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&chunk, 3, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&domain, 3, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&collective_write, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&precreate, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&set_collective_metadata, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&never_fill, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&deflate, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&subfile, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&n_nodes, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&filename, 256, MPI_CHAR, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&use_function_lib, 256, MPI_CHAR, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&use_function_name, 256, MPI_CHAR, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&use_function_argc, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&use_function_argv, 256, MPI_CHAR, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&deflate, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-    mpi_retval = MPI_Bcast(&zfp, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    assert(mpi_retval == MPI_SUCCESS);
-
-    // check the arguments
-    //FTW was:  assert(time > 0);
-    assert(simulation_time > 0);
+///////////////////////////////////////////////////////////////////////////////
+// Number of allocated chunks of dset, and how many of them start at a 
+// multiple of alignment in the file.
 
-    //assert(processor[0]*processor[1]*processor[2] == (hsize_t) mpi_size);
-    // FTW: Some things just shouldn't be assertions...
-    //assert(processor_count == mpi_size);
-    int processor_count = processor[0] * processor[1] * processor[2];
-    if (processor_count != mpi_size)
+void count_aligned_chunks
+(
+    hid_t    dset,
+    hsize_t  alignment,
+    hsize_t& n_chunks,
+    hsize_t& n_aligned
+)
+{
+    n_chunks = n_aligned = 0;
+#if H5_VERSION_GE(1,10,5)
+    hid_t fspace = H5Dget_space(dset);
+    assert(fspace >= 0);
+    herr_t herr_retval = H5Dget_num_chunks(dset, fspace, &n_chunks);
+    assert(herr_retval >= 0);
+    for (hsize_t i = 0; i < n_chunks; i++)
     {
-        if (mpi_rank==0) printf("processor count of %d doesn't match mpi_size of %d\nExiting.\n", processor_count, mpi_size);
-        exit(126);
-    } 
-
-    // I'm removing the below restriction to allow for serial case
-    // assert(processor[0] > 1 && processor[1] > 1 && processor[2] > 1);
+        unsigned filter_mask;
+        haddr_t address;
+        hsize_t size;
+        herr_retval = H5Dget_chunk_info(dset, fspace, i, NULL, &filter_mask, 
+                &address, &size);
+        assert(herr_retval >= 0);
+        if (address != HADDR_UNDEF && address % alignment == 0) n_aligned++;
+    }
+    H5Sclose(fspace);
+#endif
+}
 
-    // Subfiling and chunking not compatible, so ignore chunk info
-    if (!subfile) assert(chunk[0] > 1 && chunk[1] > 1 && chunk[2] > 1);
-    assert(domain[0] > 0 && domain[1] > 0 && domain[2] > 0);
+///////////////////////////////////////////////////////////////////////////////
+// Emulated simulation work between checkpoints. The state buffer is refreshed
+// from the initial data, then we spin until compute_time seconds have passed.
+// std::chrono is used instead of MPI_Wtime() because the background I/O
+// thread may be inside MPI at the same time.
 
-    if (mpi_rank == 0)
+double compute_phase
+(
+    vector<float>&       state,
+    const vector<float>& v,
+    double               compute_time
+)
+{
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    copy(v.begin(), v.end(), state.begin());
+    double elapsed = 0.0;
+    do
     {
-        cout << 
-        "====================================================================="
-        << endl;
-        cout << "Number of processes:\t\t" << mpi_size << endl;
-        cout << "Process layout:\t\t\t" << processor[0] << " x " <<
-            processor[1] << " x " << processor[2] << endl;
-        cout << "Per process grid:\t\t" << domain[0] << " x " << domain[1] <<
-            " x " << domain[2] << endl;
-        if (!subfile) cout << "Chunk dimensions:\t\t" << chunk[0] << " x " 
-            << chunk[1] << " x " << chunk[2] << endl;
-        if (n_nodes) cout << "n_nodes:\t\t\t" << n_nodes << endl;
-        cout << "Number of time steps:\t\t" << simulation_time << endl;
-        cout << "Pre-create:\t\t\t" << precreate << endl;
-        cout << "Collective I/O:\t\t\t" << collective_write << endl;
-        cout << "Collective metadata requested:\t" << set_collective_metadata 
-             << endl;
-        cout << "H5D_FILL_TIME_NEVER set:\t" << never_fill << endl;
-        cout << "Deflate: \t\t\t" << deflate << endl;
-        cout << "Subfile: \t\t\t" << subfile << endl;
-        cout << "ZFP: \t\t\t\t" << zfp << endl;
-        cout << "stripe size: \t\t\t" << lfs_stripe_size << endl;
-        cout << "stripe count: \t\t\t" << lfs_stripe_count << endl;
-        cout << "Output filename: \t\t" << filename << endl;
-        cout << endl;
-
-        // attempt to set striping, if requested
-        if (lfs_stripe_size || lfs_stripe_count) {
-            cout << "Finding lfs command:" << endl;
-            int lfs_status = system("which lfs");
-            if (lfs_status) {
-                cout << endl 
-                     << "Lustre lfs utility not found. " 
-                     << "File will have default striping, if any." << endl 
-                     << endl;
-            }
-            else {
-                char lfs_size_str[256];
-                lfs_size_str[0] = (char)0;
-                char lfs_count_str[256];
-                lfs_count_str[0] = (char)0;
-                if (lfs_stripe_size) sprintf(lfs_size_str, "-s %d ", lfs_stripe_size);
-                if (lfs_stripe_count) sprintf(lfs_count_str, "-c %d ", lfs_stripe_count);
-                char lfs_command[256];
-                cout << "Setting striping info:" << endl;
-                // sprintf(lfs_command, "lfs setstripe %s %s %s > /dev/null ", lfs_size_str, lfs_count_str, filename);
-                sprintf(lfs_command, "lfs setstripe %s %s %s ", lfs_size_str, lfs_count_str, filename);
-                cout << lfs_command << endl << endl;
-                // assert(system(lfs_command) == 0) ; // run striping command on shell.
-                int retval = system(lfs_command); // run striping command on shell.
-                if (retval != 0) 
-                {
-                    printf(">>>%s<<<\nCommand failed.\n", lfs_command);
-                    exit(retval);
-                }
-            }
-        }
-    }
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0)
+                      .count();
+    } while (elapsed < compute_time);
+    return elapsed;
+}
 
-    MPI_Barrier(MPI_COMM_WORLD);
+// The first n values of the block scaled, and converted to the memory type
+// when that isn't float
 
-    //////////////////////////////////////////////////////////////////////////
-    // create the fle dataspace, time dimension first!
-    hsize_t n_dims = 4;
-    hsize_t dims[H5S_MAX_RANK];
+void prepare_elements
+(
+    int            memory_type,
+    double         scale,
+    vector<float>& v,
+    vector<char>&  memory,
+    size_t         n
+)
+{
+    if (scale != 1.0)
+        for (size_t i = 0; i < n; i++) v[i] = (float) (v[i] * scale);
+    if (memory_type != ELEMENT_F32)
+        convert_elements(ELEMENT_F32, &v[0], memory_type, &memory[0], n);
+}
 
-    dims[0] = simulation_time;
-    dims[1] = processor[0]*domain[0];
-    dims[2] = processor[1]*domain[1];
-    dims[3] = processor[2]*domain[2];
+///////////////////////////////////////////////////////////////////////////////
+// Direct chunk writes: the block is cut into its chunks, which are deflated
+// by a pool of threads and passed to H5Dwrite_chunk(), bypassing the filter
+// pipeline. Without deflate the chunks are only packed, and a block that is
+// a single chunk is written straight from the buffer (zero copy).
 
-    hid_t fspace = H5Screate_simple(n_dims, dims, NULL);
-    assert(fspace >= 0);
+struct chunk_writer
+{
+    hsize_t  block[3];                     // block dimensions
+    hsize_t  chunk[3];                     // chunk dimensions, dividing block
+    hsize_t  offset[3];                    // where the block starts
+    int      threads;
+    int      deflate;                      // level, 0 for none
+    vector<vector<unsigned char> > chunks; // packed or deflated chunks
+    vector<size_t> sizes;
+    double   compress_total;               // packing and deflating
+    double   bytes_in, bytes_out;
+};
 
-    // set up chunking... NOTE: extent of time dimension is 1
+size_t chunks_in_block(const chunk_writer* cw)
+{
+    return (cw->block[0] / cw->chunk[0]) * (cw->block[1] / cw->chunk[1]) * 
+        (cw->block[2] / cw->chunk[2]);
+}
 
-    hsize_t cdims[H5S_MAX_RANK];
-    cdims[0] = 1;
-    cdims[1] = chunk[0];
-    cdims[2] = chunk[1];
-    cdims[3] = chunk[2];
+// the position of chunk c in the block, in units of chunks
+void chunk_position(const chunk_writer* cw, size_t c, hsize_t* position)
+{
+    hsize_t n1 = cw->block[1] / cw->chunk[1], n2 = cw->block[2] / cw->chunk[2];
+    position[0] = c / (n1 * n2);
+    position[1] = (c / n2) % n1;
+    position[2] = c % n2;
+}
 
-    // create dcpl and set properties
-    hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
-    assert(dcpl >= 0);
-    // subfiling not compatible with chunking
-    if (!subfile)
-    {  
-         herr_retval = H5Pset_chunk(dcpl, n_dims, cdims);
-         assert(herr_retval >= 0);
-    }
-    if (never_fill)
-    {
-         herr_retval = H5Pset_fill_time(dcpl, H5D_FILL_TIME_NEVER );
-         assert(herr_retval >= 0);
-    }
-    herr_retval = H5Pset_alloc_time(dcpl, H5D_ALLOC_TIME_EARLY);
-    assert(herr_retval >= 0);
-    if (deflate != 0)
-    {
-         herr_retval = H5Pset_deflate (dcpl, deflate);
-         assert(herr_retval >= 0);
-    }
-    
-#ifdef INCLUDE_ZFP
-	// ZFP
-	size_t cd_nelmts = 4;
-	unsigned int cd_values[] = {3, 0, 0, 0};
-    if (zfp != 0) 
+// worker: take the next chunk until none are left
+void compress_chunks_thread
+(
+    chunk_writer*   cw,
+    const float*    buf,
+    atomic<size_t>* next
+)
+{
+    size_t n_chunks = chunks_in_block(cw);
+    size_t row = cw->chunk[2] * sizeof(float);
+    size_t chunk_bytes = cw->chunk[0] * cw->chunk[1] * row;
+    vector<unsigned char> packed;
+    for (size_t c = (*next)++; c < n_chunks; c = (*next)++)
     {
-         herr_retval = H5Z_zfp_initialize();
-         assert(herr_retval >= 0);
-         herr_retval = H5Pset_filter(dcpl, H5Z_FILTER_ZFP, H5Z_FLAG_MANDATORY,cd_nelmts, cd_values);
-         assert(herr_retval >= 0);
+        hsize_t position[3];
+        chunk_position(cw, c, position);
+        vector<unsigned char>& out = cw->chunks[c];
+        unsigned char* dst;
+        if (cw->deflate)
+        {
+            packed.resize(chunk_bytes);
+            dst = &packed[0];
+        }
+        else
+        {
+            out.resize(chunk_bytes);
+            dst = &out[0];
+        }
+        for (hsize_t i = 0; i < cw->chunk[0]; i++)
+        for (hsize_t j = 0; j < cw->chunk[1]; j++)
+        {
+            const float* src = buf + 
+                ((position[0] * cw->chunk[0] + i) * cw->block[1] + 
+                 position[1] * cw->chunk[1] + j) * cw->block[2] + 
+                position[2] * cw->chunk[2];
+            memcpy(dst + (i * cw->chunk[1] + j) * row, src, row);
+        }
+        if (cw->deflate)
+        {
+            // the zlib stream H5Z_FILTER_DEFLATE stores and expects
+            uLongf out_size = compressBound(chunk_bytes);
+            out.resize(out_size);
+            int z_retval = compress2(&out[0], &out_size, &packed[0], 
+                    chunk_bytes, cw->deflate);
+            assert(z_retval == Z_OK);
+            cw->sizes[c] = out_size;
+        }
+        else cw->sizes[c] = chunk_bytes;
     }
-#endif
+}
 
-    hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
-    assert(dapl >= 0);
-    ///////////////////////////////////////////////////////////////////////////
-    // prepare hyperslab selection
-    hsize_t start[4], block[4], count[4] = {1,1,1,1};
+void write_chunks_direct
+(
+    chunk_writer* cw,
+    const hid_t*  dsets,
+    size_t        n_dsets,
+    hsize_t       step,
+    const float*  buf
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    size_t n_chunks = chunks_in_block(cw);
+    size_t block_bytes = cw->block[0] * cw->block[1] * cw->block[2] * 
+        sizeof(float);
+    hsize_t offset[4] = {step, cw->offset[0], cw->offset[1], cw->offset[2]};
 
-    // calculate offsets from MPI rank
-    start[3] = (hsize_t) mpi_rank % processor[2];
-    start[2] = (hsize_t) ((mpi_rank - start[3])/processor[2]) % processor[1];
-    start[1] = (hsize_t) ((mpi_rank - start[3])/processor[2] - start[2]) /
-      processor[1];
-    hsize_t domain_block_number[3];
-    domain_block_number[0] = start[1];
-    domain_block_number[1] = start[2];
-    domain_block_number[2] = start[3];
-    start[1] *= domain[0];
-    start[2] *= domain[1];
-    start[3] *= domain[2];
+    // zero copy: the block is the chunk
+    if (n_chunks == 1 && !cw->deflate)
+    {
+        for (size_t i = 0; i < n_dsets; i++)
+        {
+            herr_retval = H5Dwrite_chunk(dsets[i], H5P_DEFAULT, 0, offset, 
+                    block_bytes, buf);
+            assert(herr_retval >= 0);
+        }
+        cw->bytes_in += block_bytes;
+        cw->bytes_out += block_bytes;
+        return;
+    }
 
-    block[0] = 1;
-    block[1] = domain[0];
-    block[2] = domain[1];
-    block[3] = domain[2];
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    cw->chunks.resize(n_chunks);
+    cw->sizes.resize(n_chunks);
+    atomic<size_t> next(0);
+    vector<thread> pool;
+    for (int t = 1; t < cw->threads; t++)
+        pool.push_back(thread(compress_chunks_thread, cw, buf, &next));
+    compress_chunks_thread(cw, buf, &next);
+    for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+    cw->compress_total += chrono::duration<double>(
+            chrono::steady_clock::now() - t0).count();
 
-    ///////////////////////////////////////////////////////////////////////////
-    // data transfer property list for collective I/O, if selected
-    hid_t dxpl = H5P_DEFAULT;
-    if (collective_write)
+    for (size_t c = 0; c < n_chunks; c++)
     {
-        dxpl = H5Pcreate(H5P_DATASET_XFER);
-        herr_retval = H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
-        assert (herr_retval > 0);
+        hsize_t position[3];
+        chunk_position(cw, c, position);
+        for (int d = 0; d < 3; d++) 
+            offset[d + 1] = cw->offset[d] + position[d] * cw->chunk[d];
+        for (size_t i = 0; i < n_dsets; i++)
+        {
+            herr_retval = H5Dwrite_chunk(dsets[i], H5P_DEFAULT, 0, offset, 
+                    cw->sizes[c], &cw->chunks[c][0]);
+            assert(herr_retval >= 0);
+        }
+        cw->bytes_out += cw->sizes[c];
     }
+    cw->bytes_in += block_bytes;
+}
 
-    ///////////////////////////////////////////////////////////////////////////
-    // create in-memory dataspace
-    dims[0] = 1;
-    dims[1] = domain[0];
-    dims[2] = domain[1];
-    dims[3] = domain[2];
+///////////////////////////////////////////////////////////////////////////////
+// One timestep write, run either inline or on the background I/O thread.
+// Each buffer has its own file dataspace so the selection for step N+1 can
+// be made while step N is still in flight. With several variables the same
+// block goes to every dataset, one H5Dwrite() each or all in one 
+// H5Dwrite_multi(), or with direct, one H5Dwrite_chunk() per chunk.
 
-    hid_t mspace = H5Screate_simple(n_dims, dims, NULL);
-    assert(mspace >= 0);
-    herr_retval = H5Sselect_all(mspace);
-    assert(herr_retval >= 0);
+// Converting the block from the memory type to the file type in seism-core
+// rather than in H5Dwrite(): the converted copy, and the time spent on it.
 
-    ///////////////////////////////////////////////////////////////////////////
-    // initialize the test data to MPI rank
-    vector<float> v((size_t) domain[0]*domain[1]*domain[2], (float) mpi_rank);
+struct element_conversion
+{
+    int          from;
+    int          to;
+    hid_t        type;             // the file type, in memory
+    vector<char> buffer;
+    double       elapsed;
+};
 
-    // if we're loading a function, use it here, now.
-    // function will receive mpi_rank, argc, argv
+// The block kept inside an array padded with halo cells, as a stencil code
+// keeps it: the interior is selected in a dataspace of the padded array, or
+// packed into a contiguous buffer before each write, and the time spent 
+// packing.
 
-    if (strcmp(use_function_name, "") != 0) {
+struct halo_layout
+{
+    hsize_t       width;
+    hsize_t       dims[3];         // of the padded array
+    hsize_t       interior[3];     // of the block
+    vector<float> padded;
+    hid_t         mspace;          // the padded array, interior selected
+    bool          pack;
+    vector<float> packed;
+    double        elapsed;
+};
 
-        void *handle;
-        // This awkward cast provided to you by the ISO standards team...
-        float (*use_function)(int, hsize_t*, hsize_t*, hsize_t*, hsize_t*, int,
-                char **);
-        char *error;
+// copy the interior of the padded array to a contiguous buffer, row by row
+void pack_interior(const halo_layout& h, float* out)
+{
+    size_t row = h.interior[2];
+    for (hsize_t i = 0; i < h.interior[0]; i++)
+    for (hsize_t j = 0; j < h.interior[1]; j++)
+    {
+        const float* in = &h.padded[((i + h.width) * h.dims[1] + j + h.width) 
+            * h.dims[2] + h.width];
+        memcpy(out + (i * h.interior[1] + j) * row, in, row * sizeof(float));
+    }
+}
 
-        handle = dlopen (use_function_lib, RTLD_LAZY);
-        if (!handle) {
-            fputs (dlerror(), stderr);
-            exit(1);
-        }
+struct timestep_write
+{
+    const hid_t* dsets;
+    hid_t        mspace;
+    hid_t        fspace;
+    hid_t        dxpl;
+    const void*  buf;
+    double       elapsed;
+    size_t       n_elements;
+    uint64_t*    digest;           // if not NULL, digest buf into here
+    double       digest_elapsed;
+    size_t       n_dsets;
+    int          multi;            // use H5Dwrite_multi()
+    chunk_writer* direct;          // if not NULL, write chunks directly
+    hsize_t      step;             // for direct chunk writes
+    hid_t        mem_type;         // of buf
+    element_conversion* convert;   // if not NULL, convert buf before writing
+    halo_layout* halo;             // if not NULL, write from the padded array
+};
 
-        *(void **) (&use_function) = dlsym(handle, use_function_name);
-        if ((error = dlerror()) != NULL)  {
-            fputs(error, stderr);
-            exit(1);
-        }
+// the write of one timestep, with every other member cleared
+timestep_write make_timestep_write(const hid_t* dsets, hid_t mspace, 
+        hid_t fspace, hid_t dxpl, const void* buf)
+{
+    timestep_write w = timestep_write();
+    w.dsets = dsets;
+    w.mspace = mspace;
+    w.fspace = fspace;
+    w.dxpl = dxpl;
+    w.buf = buf;
+    return w;
+}
 
-        // split use_function_argv into tokens, then pass to library function
-        
-        const char *array[16];
-        for (int i = 0; i < use_function_argc; i++) {
-            if (i == 0) array[i] = strtok(use_function_argv, " ");
-            else array[i] = strtok(NULL, " ");
-        }   
+void digest_timestep(timestep_write* w)
+{
+    if (!w->digest) return;
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    *w->digest = seism_core_digest(w->buf, w->n_elements * sizeof(float));
+    w->digest_elapsed = chrono::duration<double>(
+            chrono::steady_clock::now() - t0).count();
+}
 
-        hsize_t position_in_block[3];
-        for (position_in_block[0] = 0; position_in_block[0] < domain[0]; position_in_block[0]++)
-        for (position_in_block[1] = 0; position_in_block[1] < domain[1]; position_in_block[1]++)
-        for (position_in_block[2] = 0; position_in_block[2] < domain[2]; position_in_block[2]++)
+void write_timestep(timestep_write* w)
+{
+    digest_timestep(w);
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    herr_t herr_retval = (herr_t) 0;
+    const void* buf = w->buf;
+    hid_t mem_type = w->mem_type;
+    hid_t mspace = w->mspace;
+    if (w->halo)
+    {
+        // buf, the block, is only digested; what's written is in the halo
+        halo_layout* h = w->halo;
+        if (h->pack)
         {
-            hsize_t index = position_in_block[0] * domain[1] * domain[2] + position_in_block[1] * domain[2] + position_in_block[2];
-            v[index] = (*use_function)(mpi_rank, processor, domain, domain_block_number, position_in_block, use_function_argc, (char **)array);
+            pack_interior(*h, &h->packed[0]);
+            h->elapsed += chrono::duration<double>(
+                    chrono::steady_clock::now() - t0).count();
+            buf = &h->packed[0];
+        }
+        else
+        {
+            buf = &h->padded[0];
+            mspace = h->mspace;
         }
-
-        dlclose(handle);
+    }
+    if (w->convert)
+    {
+        element_conversion* c = w->convert;
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        convert_elements(c->from, buf, c->to, &c->buffer[0], w->n_elements);
+        c->elapsed += chrono::duration<double>(chrono::steady_clock::now() - t1)
+                          .count();
+        buf = &c->buffer[0];
+        mem_type = c->type;
+    }
+    if (w->direct)
+        write_chunks_direct(w->direct, w->dsets, w->n_dsets, w->step, 
+                (const float*) buf);
+    else
+#if H5_VERSION_GE(1,14,0)
+    if (w->multi && w->n_dsets > 1)
+    {
+        vector<hid_t> mem_types(w->n_dsets, mem_type);
+        vector<hid_t> mspaces(w->n_dsets, mspace);
+        vector<hid_t> fspaces(w->n_dsets, w->fspace);
+        vector<const void*> bufs(w->n_dsets, buf);
+        herr_retval = H5Dwrite_multi(w->n_dsets, (hid_t*) w->dsets, &mem_types[0],
+                &mspaces[0], &fspaces[0], w->dxpl, &bufs[0]);
+        assert (herr_retval >= 0);
+    }
+    else
+#endif
+    for (size_t i = 0; i < w->n_dsets; i++)
+    {
+        herr_retval = H5Dwrite(w->dsets[i], mem_type, mspace,
+                w->fspace, w->dxpl, buf);
+        assert (herr_retval >= 0);
+    }
+    w->elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0)
+                     .count();
+}
+
+#if H5_VERSION_GE(1,13,0)
+// adds up the execution times of the operations of an event set, in seconds
+// at ctx, as far as the connector reports them
+int event_complete(H5ES_op_info_t* op_info, H5ES_status_t, hid_t, void* ctx)
+{
+    *(double*) ctx += 1.0e-9 * (double) op_info->op_exec_time;
+    return 0;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Grow the time dimension of every dataset to n_steps, and the dataspace the
+// selections are made in with it. Collective over the file's ranks. With 
+// early allocation this is where the new chunks get allocated.
+
+double extend_time_dimension
+(
+    const hid_t* dsets,
+    size_t       n_dsets,
+    hid_t        fspace,
+    hsize_t      n_steps
+)
+{
+    double t0 = MPI_Wtime();
+    hsize_t dims[4], maxdims[4];
+    int n_dims = H5Sget_simple_extent_dims(fspace, dims, maxdims);
+    assert(n_dims == 4);
+    dims[0] = n_steps;
+    for (size_t i = 0; i < n_dsets; i++)
+    {
+        herr_t herr_retval = H5Dset_extent(dsets[i], dims);
+        assert(herr_retval >= 0);
+    }
+    herr_t herr_retval = H5Sset_extent_simple(fspace, 4, dims, maxdims);
+    assert(herr_retval >= 0);
+    return MPI_Wtime() - t0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Collectively create the digests dataset, time x processor grid, and write
+// the digests of this rank's blocks for all timesteps. Usually that is one 
+// block, I/O servers write those of all their clients: block_numbers holds
+// three numbers per block, digests simulation_time values per block.
+
+void write_digests
+(
+    hid_t                   file,
+    unsigned int            simulation_time,
+    const hsize_t*          processor,
+    const vector<hsize_t>&  block_numbers,
+    const vector<uint64_t>& digests,
+    hid_t                   dxpl
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+
+    hsize_t dims[4] = {simulation_time, processor[0], processor[1], 
+        processor[2]};
+    hid_t fspace = H5Screate_simple(4, dims, NULL);
+    assert(fspace >= 0);
+    hid_t dset = H5Dcreate(file, DIGEST_DSET_NAME, H5T_STD_U64LE, fspace,
+            H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    assert(dset >= 0);
+
+    // name the algorithm, so it can be changed later
+    hid_t str_t = H5Tcopy(H5T_C_S1);
+    H5Tset_size(str_t, strlen(DIGEST_ALGORITHM) + 1);
+    hid_t aspace = H5Screate(H5S_SCALAR);
+    hid_t attr = H5Acreate(dset, "algorithm", str_t, aspace, H5P_DEFAULT,
+            H5P_DEFAULT);
+    assert(attr >= 0);
+    herr_retval = H5Awrite(attr, str_t, DIGEST_ALGORITHM);
+    assert(herr_retval >= 0);
+    H5Aclose(attr);
+    H5Sclose(aspace);
+    H5Tclose(str_t);
+
+    // HDF5 walks a union of blocks in file order, i.e. by timestep, then 
+    // by block position, so put the digests in that order
+    size_t n_blocks = block_numbers.size() / 3;
+    vector<size_t> order(n_blocks);
+    for (size_t b = 0; b < n_blocks; b++) order[b] = b;
+    sort(order.begin(), order.end(), [&block_numbers, processor](size_t a, size_t b) {
+            const hsize_t* x = &block_numbers[3 * a];
+            const hsize_t* y = &block_numbers[3 * b];
+            return (x[0] * processor[1] + x[1]) * processor[2] + x[2] < 
+                   (y[0] * processor[1] + y[1]) * processor[2] + y[2]; });
+    vector<uint64_t> ordered(max(n_blocks * simulation_time, (size_t) 1));
+    for (unsigned int t = 0; t < simulation_time; t++)
+        for (size_t b = 0; b < n_blocks; b++)
+            ordered[t * n_blocks + b] = digests[order[b] * simulation_time + t];
+
+    hsize_t count[4] = {1, 1, 1, 1};
+    hsize_t block[4] = {simulation_time, 1, 1, 1};
+    herr_retval = H5Sselect_none(fspace);
+    assert(herr_retval >= 0);
+    for (size_t b = 0; b < n_blocks; b++)
+    {
+        hsize_t start[4] = {0, block_numbers[3 * b], block_numbers[3 * b + 1],
+            block_numbers[3 * b + 2]};
+        herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_OR, start, NULL, 
+                count, block);
+        assert(herr_retval >= 0);
+    }
+    hsize_t mdims[1] = {ordered.size()};
+    hid_t mspace = H5Screate_simple(1, mdims, NULL);
+    assert(mspace >= 0);
+    if (!n_blocks) 
+    {
+        herr_retval = H5Sselect_none(mspace);
+        assert(herr_retval >= 0);
+    }
+    herr_retval = H5Dwrite(dset, H5T_NATIVE_UINT64, mspace, fspace, dxpl, 
+            &ordered[0]);
+    assert(herr_retval >= 0);
+
+    H5Sclose(mspace);
+    H5Sclose(fspace);
+    H5Dclose(dset);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// nearest-rank percentile q (0..1] of an ascending sorted vector
+
+double percentile(const vector<double>& sorted, double q)
+{
+    size_t i = (size_t) ceil(q * sorted.size());
+    if (i > 0) i--;
+    return sorted[min(i, sorted.size() - 1)];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Called on process 0 with the H5Dwrite() time of every rank for every
+// timestep (rank-major) and the MPI_MAX_PROCESSOR_NAME sized hostname of 
+// every rank. Prints per-step statistics and the slowest ranks, and writes
+// the same as <timing_file>.json plus the raw samples as <timing_file>.csv.
+// When only some ranks write, times and hosts hold just those, and ranks
+// gives their rank in the communicator of the case.
+
+void report_timestep_timings
+(
+    const char*           timing_file,
+    const vector<double>& times,
+    const vector<char>&   hosts,
+    const vector<int>&    ranks,
+    unsigned int          simulation_time
+)
+{
+    const int mpi_size = ranks.size();
+    const int n_slowest = min(mpi_size, 3);
+
+    // per-rank totals, for the overall imbalance and the stragglers
+    vector<double> rank_total(mpi_size, 0.0);
+    for (int r = 0; r < mpi_size; r++)
+        for (unsigned int t = 0; t < simulation_time; t++)
+            rank_total[r] += times[(size_t) r * simulation_time + t];
+    double mean_total = 0.0;
+    for (int r = 0; r < mpi_size; r++) mean_total += rank_total[r];
+    mean_total /= mpi_size;
+    vector<int> slowest(mpi_size);
+    for (int r = 0; r < mpi_size; r++) slowest[r] = r;
+    partial_sort(slowest.begin(), slowest.begin() + n_slowest, slowest.end(),
+            [&rank_total](int a, int b) { return rank_total[a] > rank_total[b]; });
+    double imbalance = mean_total > 0.0 ? 
+        rank_total[slowest[0]] / mean_total : 1.0;
+
+    string json_name = string(timing_file) + ".json";
+    string csv_name = string(timing_file) + ".csv";
+    ofstream json(json_name.c_str());
+    json << "{" << endl;
+    json << "  \"ranks\": " << mpi_size << "," << endl;
+    json << "  \"timesteps\": " << simulation_time << "," << endl;
+    json << "  \"load_imbalance\": " << imbalance << "," << endl;
+    json << "  \"steps\": [" << endl;
+
+    cout << "Per-step H5Dwrite() time over ranks [s]:" << endl;
+    cout << "  step\tmin\t\tmedian\t\tp95\t\tp99\t\tmax\t\timbalance" 
+         << endl;
+    vector<double> step(mpi_size);
+    for (unsigned int t = 0; t < simulation_time; t++)
+    {
+        double sum = 0.0;
+        for (int r = 0; r < mpi_size; r++)
+        {
+            step[r] = times[(size_t) r * simulation_time + t];
+            sum += step[r];
+        }
+        sort(step.begin(), step.end());
+        double step_imbalance = sum > 0.0 ? step.back() / (sum / mpi_size) : 1.0;
+        cout << "  " << t << "\t" << step.front() << "\t" 
+             << percentile(step, 0.5) << "\t" << percentile(step, 0.95) << "\t" 
+             << percentile(step, 0.99) << "\t" << step.back() << "\t" 
+             << step_imbalance << endl;
+        json << "    {\"step\": " << t 
+             << ", \"min\": " << step.front()
+             << ", \"median\": " << percentile(step, 0.5)
+             << ", \"p95\": " << percentile(step, 0.95)
+             << ", \"p99\": " << percentile(step, 0.99)
+             << ", \"max\": " << step.back()
+             << ", \"imbalance\": " << step_imbalance << "}"
+             << (t + 1 < simulation_time ? "," : "") << endl;
+    }
+    json << "  ]," << endl;
+
+    cout << "Load imbalance (max/mean):\t" << imbalance << endl;
+    cout << "Slowest ranks:" << endl;
+    json << "  \"slowest_ranks\": [" << endl;
+    for (int i = 0; i < n_slowest; i++)
+    {
+        int r = slowest[i];
+        const char* host = &hosts[(size_t) r * MPI_MAX_PROCESSOR_NAME];
+        cout << "  rank " << ranks[r] << " on " << host << ":\t" 
+             << rank_total[r] << " s" << endl;
+        json << "    {\"rank\": " << ranks[r] << ", \"host\": \"" << host 
+             << "\", \"total\": " << rank_total[r] << "}"
+             << (i + 1 < n_slowest ? "," : "") << endl;
+    }
+    json << "  ]" << endl;
+    json << "}" << endl;
+    json.close();
+
+    ofstream csv(csv_name.c_str());
+    csv << "rank,host,step,write_time" << endl;
+    for (int r = 0; r < mpi_size; r++)
+        for (unsigned int t = 0; t < simulation_time; t++)
+            csv << ranks[r] << "," << &hosts[(size_t) r * MPI_MAX_PROCESSOR_NAME] 
+                << "," << t << "," << times[(size_t) r * simulation_time + t] 
+                << endl;
+    csv.close();
+
+    cout << "Timings written to:\t\t" << json_name << ", " << csv_name << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// All inputs of a single run. Plain data, so that process 0 can parse it and
+// broadcast it to everybody as bytes.
+
+struct seism_core_config
+{
+    char         filename[256];
+    unsigned int simulation_time;
+    hsize_t      processor[3];
+    hsize_t      chunk[3];
+    hsize_t      domain[3];
+    int          collective_write;
+    int          precreate;
+    int          set_collective_metadata;
+    int          never_fill;
+    int          deflate;
+    int          subfile;
+    int          n_nodes;
+    unsigned     lfs_stripe_count;
+    unsigned     lfs_stripe_size;
+    char         use_function_lib[256];
+    char         use_function_name[256];
+    int          use_function_argc;
+    char         use_function_argv[256];
+    int          zfp;
+    double       compute_time;
+    int          async_write;
+    char         timing_file[256];
+    int          keep_files;
+    int          digest;
+    int          io_servers;
+    int          node_aggregate;
+    int          variables;
+    int          multi_dataset;
+    int          extend_time;
+    hsize_t      mdc_size[3];
+    int          mdc_no_evictions;
+    char         file_space_strategy[32];
+    int          file_space_persist;
+    hsize_t      file_space_page_size;
+    hsize_t      page_buffer_size;
+    hsize_t      meta_block_size;
+    int          coll_metadata_write;
+    int          evict_on_close;
+    hsize_t      align[2];       // alignment, threshold
+    int          direct_chunk;   // compression threads, 0 for the pipeline
+    char         filters[256];   // "filter" stages, separated by ';'
+    hsize_t      memory_budget;  // bytes per slab, 0 for the whole block
+    char         results_file[256];     // results store, appended to
+    char         compare_results[256];  // baseline results store
+    double       compare_alpha;         // significance level of a slowdown
+    double       compare_threshold;     // and its least size, in percent
+    int          file_type;             // seism_core_element_type, or -1
+    int          memory_type;
+    int          own_conversion;        // convert here rather than in HDF5
+    double       type_scale;            // values are multiplied by it, 0 is 1
+    int          halo;                  // width of the halo around the block
+    int          halo_pack;             // pack the interior before writing
+    char         split[3][256];         // block sizes along each axis, or ""
+    double       imbalance;             // random block sizes up to this ratio
+    unsigned     imbalance_seed;
+    int          file_groups;           // piece files: -1 one per process, 
+                                        // -2 per node, 0 one shared file
+    int          subfiling;             // the subfiling VFD of HDF5 1.14+
+    hsize_t      subfiling_stripe_size; // 0 for the library default
+    char         subfiling_ioc[32];     // "node [n]", "nth <n>", "total <n>"
+    int          scaling;               // 1 weak, 2 strong, 0 neither
+    int          scaling_min;           // ranks of the smallest run
+};
+
+// what process 0 keeps of each run for the sweep comparison table
+struct seism_core_result
+{
+    double  create_time;
+    double  write_time;
+    double  close_time;
+    double  write_throughput;
+    double  aggregate_throughput;
+    hsize_t storage_size;
+    double  compression_ratio;     // of the filter chain, in memory
+    double  compress_throughput;
+    double  decompress_throughput;
+    int     slowdown;              // slower than its baseline
+    int     piece_files;           // next to the output file, to remove
+    int     skipped;               // a combination that can't be written
+};
+
+void default_config(seism_core_config& cfg)
+{
+    memset(&cfg, 0, sizeof(cfg));
+    strcpy(cfg.filename, "seism-test.h5");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Binary options are set by their presence, or explicitly by a trailing 0/1
+// so that they can be swept.
+
+int read_flag(istream& in)
+{
+    string rest_of_line;
+    getline(in, rest_of_line);
+    istringstream iss(rest_of_line);
+    int value;
+    if (!(iss >> value)) value = 1;
+    return value;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// parse the parameters of a single run, up to DONE or the end of input
+
+void parse_config(istream& in, seism_core_config& cfg)
+{
+    string parameter, rest_of_line;
+
+    while (in >> parameter)
+    {
+        if (parameter.at(0) == '#') continue; // ignore as comment
+        if (parameter.at(0) == 0) continue; // ignore empty line
+        if (!parameter.compare("DONE")) break; // exit
+        if (!parameter.compare("processor"))
+          in >> cfg.processor[0] >> cfg.processor[1] >> cfg.processor[2];
+        if (!parameter.compare("chunk"))
+          in >> cfg.chunk[0] >> cfg.chunk[1] >> cfg.chunk[2];
+        if (!parameter.compare("domain"))
+          in >> cfg.domain[0] >> cfg.domain[1] >> cfg.domain[2];
+        if (!parameter.compare("time"))
+          in >> cfg.simulation_time;
+        if (!parameter.compare("collective_write"))
+        {
+            cfg.collective_write = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("precreate"))
+        {
+            cfg.precreate = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("set_collective_metadata"))
+        {
+            cfg.set_collective_metadata = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("never_fill"))
+        {
+            cfg.never_fill = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("deflate"))
+          in >> cfg.deflate;
+        if (!parameter.compare("subfile"))
+          in >> cfg.subfile;
+        if (!parameter.compare("n_nodes"))
+          in >> cfg.n_nodes;
+        if (!parameter.compare("lfs_stripe_count"))
+          in >> cfg.lfs_stripe_count;
+        if (!parameter.compare("lfs_stripe_size"))
+          in >> cfg.lfs_stripe_size;
+        if (!parameter.compare("align"))
+        {
+            // alignment, optionally followed by the threshold
+            getline(in, rest_of_line);
+            istringstream iss(rest_of_line);
+            iss >> cfg.align[0] >> cfg.align[1];
+            continue;
+        }
+        if (!parameter.compare("filename"))
+          in >> cfg.filename;
+        if (!parameter.compare("use_function_lib"))
+          in >> cfg.use_function_lib;
+        if (!parameter.compare("use_function_name"))
+          in >> cfg.use_function_name;
+        if (!parameter.compare("use_function_argc"))
+          in >> cfg.use_function_argc;
+        if (!parameter.compare("use_function_argv"))
+        {
+            // read the rest of the line
+            string use_function_argv_string;
+            getline(in, use_function_argv_string);
+            strncpy(cfg.use_function_argv, use_function_argv_string.c_str(), 255);
+            continue;
+        }
+        if (!parameter.compare("zfp"))
+          in >> cfg.zfp;
+        if (!parameter.compare("compute_time"))
+          in >> cfg.compute_time;
+        if (!parameter.compare("async_write"))
+        {
+            cfg.async_write = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("timing_file"))
+        {
+            in >> rest_of_line;
+            snprintf(cfg.timing_file, sizeof(cfg.timing_file), "%s", 
+                    rest_of_line.c_str());
+        }
+        if (!parameter.compare("keep_files"))
+        {
+            cfg.keep_files = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("digest"))
+        {
+            cfg.digest = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("io_servers"))
+          in >> cfg.io_servers;
+        if (!parameter.compare("node_aggregate"))
+        {
+            cfg.node_aggregate = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("variables"))
+          in >> cfg.variables;
+        if (!parameter.compare("multi_dataset"))
+        {
+            cfg.multi_dataset = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("extend_time"))
+        {
+            cfg.extend_time = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("mdc_size"))
+          in >> cfg.mdc_size[0] >> cfg.mdc_size[1] >> cfg.mdc_size[2];
+        if (!parameter.compare("mdc_no_evictions"))
+        {
+            cfg.mdc_no_evictions = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("file_space_strategy"))
+        {
+            string strategy;
+            in >> strategy;
+            strncpy(cfg.file_space_strategy, strategy.c_str(), 31);
+        }
+        if (!parameter.compare("file_space_persist"))
+        {
+            cfg.file_space_persist = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("file_space_page_size"))
+          in >> cfg.file_space_page_size;
+        if (!parameter.compare("page_buffer_size"))
+          in >> cfg.page_buffer_size;
+        if (!parameter.compare("meta_block_size"))
+          in >> cfg.meta_block_size;
+        if (!parameter.compare("coll_metadata_write"))
+        {
+            cfg.coll_metadata_write = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("evict_on_close"))
+        {
+            cfg.evict_on_close = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("direct_chunk"))
+        {
+            cfg.direct_chunk = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("memory_budget"))
+          in >> cfg.memory_budget;
+        if (!parameter.compare("scaling"))
+        {
+            // weak or strong, then optionally the smallest number of ranks
+            getline(in, rest_of_line);
+            istringstream iss(rest_of_line);
+            string kind;
+            iss >> kind;
+            if (kind == "weak") cfg.scaling = 1;
+            if (kind == "strong") cfg.scaling = 2;
+            if (!(iss >> cfg.scaling_min)) cfg.scaling_min = 1;
+            continue;
+        }
+        if (!parameter.compare("file_type"))
+        {
+            in >> rest_of_line;
+            cfg.file_type = element_type_of(rest_of_line.c_str());
+        }
+        if (!parameter.compare("memory_type"))
+        {
+            in >> rest_of_line;
+            cfg.memory_type = element_type_of(rest_of_line.c_str());
+        }
+        if (!parameter.compare("own_conversion"))
+        {
+            cfg.own_conversion = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("type_scale"))
+          in >> cfg.type_scale;
+        if (!parameter.compare("halo"))
+          in >> cfg.halo;
+        if (!parameter.compare("halo_pack"))
+        {
+            cfg.halo_pack = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("split"))
+        {
+            // the block sizes along one axis, one per process in that 
+            // direction
+            getline(in, rest_of_line);
+            istringstream iss(rest_of_line);
+            int axis = -1;
+            string size, sizes;
+            iss >> axis;
+            while (iss >> size) sizes += (sizes.empty() ? "" : " ") + size;
+            if (axis >= 0 && axis < 3) 
+                strncpy(cfg.split[axis], sizes.c_str(), 255);
+            else printf("split needs an axis, 0, 1 or 2, ignored.\n");
+            continue;
+        }
+        if (!parameter.compare("imbalance"))
+        {
+            // the ratio, optionally followed by the seed
+            getline(in, rest_of_line);
+            istringstream iss(rest_of_line);
+            iss >> cfg.imbalance >> cfg.imbalance_seed;
+            continue;
+        }
+        if (!parameter.compare("file_groups"))
+        {
+            // a number of files, or one per process or node
+            in >> rest_of_line;
+            if (rest_of_line == "process") cfg.file_groups = -1;
+            else if (rest_of_line == "node") cfg.file_groups = -2;
+            else
+            {
+                // anything but a number fails the check in run_case
+                char* end;
+                long n = strtol(rest_of_line.c_str(), &end, 10);
+                cfg.file_groups = (*end || end == rest_of_line.c_str() || n < 0)
+                    ? -3 : (int) n;
+            }
+        }
+        if (!parameter.compare("subfiling"))
+        {
+            cfg.subfiling = read_flag(in);
+            continue;
+        }
+        if (!parameter.compare("subfiling_stripe_size"))
+          in >> cfg.subfiling_stripe_size;
+        if (!parameter.compare("subfiling_ioc"))
+        {
+            // the selection method, optionally followed by the count
+            getline(in, rest_of_line);
+            istringstream iss(rest_of_line);
+            string method, count;
+            iss >> method >> count;
+            if (!count.empty()) method += " " + count;
+            strncpy(cfg.subfiling_ioc, method.c_str(), 31);
+            continue;
+        }
+        if (!parameter.compare("results_file"))
+          in >> cfg.results_file;
+        if (!parameter.compare("compare_results"))
+        {
+            // the baseline, then optionally the significance level and the
+            // least slowdown that counts
+            getline(in, rest_of_line);
+            istringstream iss(rest_of_line);
+            iss >> cfg.compare_results;
+            if (!(iss >> cfg.compare_alpha)) cfg.compare_alpha = 0.05;
+            if (!(iss >> cfg.compare_threshold)) cfg.compare_threshold = 5.0;
+            continue;
+        }
+        if (!parameter.compare("filter"))
+        {
+            // one stage of the filter chain per line, applied in order
+            getline(in, rest_of_line);
+            istringstream iss(rest_of_line);
+            string word, stage;
+            while (iss >> word) stage += (stage.empty() ? "" : " ") + word;
+            size_t length = strlen(cfg.filters);
+            if (length && length < 255) cfg.filters[length++] = ';';
+            strncpy(cfg.filters + length, stage.c_str(), 255 - length);
+            continue;
+        }
+        getline(in, rest_of_line); // read the rest of the line
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sweep values: a numeric argument may be a comma separated list (0,1,6), an
+// inclusive range start:stop[:step] (90:360:90), or a list of ranges.
+
+bool is_sweep_token(const string& token)
+{
+    if (token.find_first_of(",:") == string::npos) return false;
+    return token.find_first_not_of("0123456789.,:-+eE") == string::npos;
+}
+
+vector<string> expand_sweep_token(const string& token)
+{
+    vector<string> values;
+    if (!is_sweep_token(token))
+    {
+        values.push_back(token);
+        return values;
+    }
+
+    string item;
+    istringstream list(token);
+    while (getline(list, item, ','))
+    {
+        if (item.find(':') == string::npos)
+        {
+            values.push_back(item);
+            continue;
+        }
+
+        string part[3];
+        int n_parts = 0;
+        istringstream range(item);
+        while (n_parts < 3 && getline(range, part[n_parts], ':')) n_parts++;
+        double first = atof(part[0].c_str());
+        double last = atof(part[1].c_str());
+        double step = (n_parts == 3) ? atof(part[2].c_str()) : 1.0;
+        if (!(step > 0.0))
+        {
+            printf("The step of the range %s must be positive\nExiting.\n", 
+                    item.c_str());
+            exit(126);
+        }
+        for (long i = 0; first + i * step <= last + 1.0e-9 * step; i++)
+        {
+            ostringstream ost;
+            ost.precision(15);
+            ost << (first + i * step);
+            values.push_back(ost.str());
+        }
+    }
+    return values;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Process 0 reads the input as a series of blocks. Each block is ended by 
+// NEXT, the last one by DONE (or the end of input). Every block is expanded 
+// into the cartesian product of its sweep values, giving one case, plus a
+// label naming the swept lines, per combination.
+
+void read_cases(istream& in, vector<string>& cases, vector<string>& labels)
+{
+    bool done = false;
+    int n_blocks = 0;
+    while (!done)
+    {
+        // collect one block, with each line expanded into its alternatives
+        vector< vector<string> > block;
+        vector<bool> swept;
+        string line;
+        done = true;
+        while (getline(in, line))
+        {
+            istringstream iss(line);
+            vector<string> tokens;
+            string token;
+            while (iss >> token) tokens.push_back(token);
+            if (tokens.empty() || tokens[0].at(0) == '#') continue;
+            if (!tokens[0].compare("DONE")) break;
+            if (!tokens[0].compare("NEXT")) 
+            {
+                done = false;
+                break;
+            }
+
+            vector<string> alternatives(1, tokens[0]);
+            for (size_t t = 1; t < tokens.size(); t++)
+            {
+                vector<string> values = expand_sweep_token(tokens[t]);
+                vector<string> expanded;
+                for (size_t a = 0; a < alternatives.size(); a++)
+                    for (size_t b = 0; b < values.size(); b++)
+                        expanded.push_back(alternatives[a] + " " + values[b]);
+                alternatives.swap(expanded);
+            }
+            block.push_back(alternatives);
+            swept.push_back(alternatives.size() > 1);
+        }
+        if (block.empty()) continue;
+        n_blocks++;
+
+        // odometer over the alternatives of every line
+        vector<size_t> index(block.size(), 0);
+        while (true)
+        {
+            string text, label;
+            for (size_t l = 0; l < block.size(); l++)
+            {
+                text += block[l][index[l]] + "\n";
+                if (swept[l]) 
+                    label += (label.empty() ? "" : "; ") + block[l][index[l]];
+            }
+            if (label.empty()) label = "block " + to_string(n_blocks);
+            cases.push_back(text + "DONE\n");
+            labels.push_back(label);
+
+            size_t l = 0;
+            while (l < block.size() && ++index[l] == block[l].size()) 
+                index[l++] = 0;
+            if (l == block.size()) break;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// comparison table printed by process 0 at the end of a sweep
+
+void report_sweep
+(
+    const vector<string>&            labels,
+    const vector<seism_core_result>& results
+)
+{
+    cout << 
+    "====================================================================="
+         << endl;
+    cout << "Sweep of " << results.size() << " cases:" << endl;
+    cout << "case\tcreate [s]\twrite [s]\twrite [MB/s]\taggregate [MB/s]"
+         << "\tstored [bytes]\tratio\tcompress [MB/s]\tdecompress [MB/s]"
+         << "\tparameters" << endl;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (results[i].skipped)
+        {
+            cout << i + 1 << "\tskipped" << string(13, '\t') << labels[i] << endl;
+            continue;
+        }
+        cout << i + 1 << "\t" << results[i].create_time 
+             << "\t" << results[i].write_time
+             << "\t" << results[i].write_throughput 
+             << "\t\t" << results[i].aggregate_throughput 
+             << "\t\t" << results[i].storage_size 
+             << "\t\t" << results[i].compression_ratio 
+             << "\t" << results[i].compress_throughput 
+             << "\t\t" << results[i].decompress_throughput 
+             << "\t\t" << labels[i] << endl;
+    }
+    cout << 
+    "====================================================================="
+         << endl << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Results store: with results_file, process 0 appends every case to it as one
+// line of JSON, with its configuration, the HDF5 and MPI versions, the hints
+// passed to MPI-IO and the measured phases. A case is identified by a hash of
+// its configuration, which leaves out file names and parameters at their
+// defaults, so that it survives new parameters being added. compare_results
+// finds earlier runs with the same hash in a baseline store and tests whether
+// the per-step write times got slower, with a one-sided Mann-Whitney U test,
+// which doesn't assume that I/O times are normally distributed. A slowdown 
+// must also be large enough to matter: a busy file system makes small ones
+// significant all the time.
+
+string json_string(const char* s)
+{
+    string quoted = "\"";
+    for (; *s; s++)
+    {
+        if ((unsigned char) *s < 0x20) { quoted += ' '; continue; }
+        if (*s == '"' || *s == '\\') quoted += '\\';
+        quoted += *s;
+    }
+    return quoted + "\"";
+}
+
+template<class T> string json_value(T value)
+{
+    ostringstream out;
+    out << value;
+    return out.str();
+}
+
+template<class T> string json_array(const T* values, size_t n)
+{
+    string array = "[";
+    for (size_t i = 0; i < n; i++) 
+        array += (i ? ", " : "") + json_value(values[i]);
+    return array + "]";
+}
+
+// name and JSON value of every parameter of a case: the members of 
+// seismCoreAttributes under their names, then what the file doesn't record
+vector<pair<string, string> > results_config
+(
+    const seism_core_config& cfg,
+    int                      mpi_size
+)
+{
+    vector<pair<string, string> > f;
+    f.push_back(make_pair("processor_dims", json_array(cfg.processor, 3)));
+    f.push_back(make_pair("chunk_dims", json_array(cfg.chunk, 3)));
+    f.push_back(make_pair("domain_dims", json_array(cfg.domain, 3)));
+    f.push_back(make_pair("simulation_time", json_value(cfg.simulation_time)));
+    f.push_back(make_pair("n_nodes", json_value(cfg.n_nodes)));
+    f.push_back(make_pair("subfile", json_value(cfg.subfile)));
+    f.push_back(make_pair("collective_write", json_value(cfg.collective_write)));
+    f.push_back(make_pair("precreate", json_value(cfg.precreate)));
+    f.push_back(make_pair("set_collective_metadata", 
+                json_value(cfg.set_collective_metadata)));
+    f.push_back(make_pair("never_fill", json_value(cfg.never_fill)));
+    f.push_back(make_pair("deflate", json_value(cfg.deflate)));
+    f.push_back(make_pair("zfp", json_value(cfg.zfp)));
+    f.push_back(make_pair("use_function_lib", json_string(cfg.use_function_lib)));
+    f.push_back(make_pair("use_function_name", json_string(cfg.use_function_name)));
+    f.push_back(make_pair("use_function_argc", json_value(cfg.use_function_argc)));
+    f.push_back(make_pair("use_function_argv", json_string(cfg.use_function_argv)));
+    f.push_back(make_pair("mdc_size", json_array(cfg.mdc_size, 3)));
+    f.push_back(make_pair("mdc_no_evictions", json_value(cfg.mdc_no_evictions)));
+    f.push_back(make_pair("file_space_strategy", 
+                json_string(cfg.file_space_strategy)));
+    f.push_back(make_pair("file_space_persist", json_value(cfg.file_space_persist)));
+    f.push_back(make_pair("file_space_page_size", 
+                json_value(cfg.file_space_page_size)));
+    f.push_back(make_pair("page_buffer_size", json_value(cfg.page_buffer_size)));
+    f.push_back(make_pair("meta_block_size", json_value(cfg.meta_block_size)));
+    f.push_back(make_pair("coll_metadata_write", 
+                json_value(cfg.coll_metadata_write)));
+    f.push_back(make_pair("evict_on_close", json_value(cfg.evict_on_close)));
+    f.push_back(make_pair("filters", json_string(cfg.filters)));
+    f.push_back(make_pair("mpi_size", json_value(mpi_size)));
+    f.push_back(make_pair("variables", json_value(cfg.variables)));
+    f.push_back(make_pair("multi_dataset", json_value(cfg.multi_dataset)));
+    f.push_back(make_pair("extend_time", json_value(cfg.extend_time)));
+    f.push_back(make_pair("compute_time", json_value(cfg.compute_time)));
+    f.push_back(make_pair("async_write", json_value(cfg.async_write)));
+    f.push_back(make_pair("digest", json_value(cfg.digest)));
+    f.push_back(make_pair("io_servers", json_value(cfg.io_servers)));
+    f.push_back(make_pair("node_aggregate", json_value(cfg.node_aggregate)));
+    f.push_back(make_pair("lfs_stripe_count", json_value(cfg.lfs_stripe_count)));
+    f.push_back(make_pair("lfs_stripe_size", json_value(cfg.lfs_stripe_size)));
+    f.push_back(make_pair("align", json_array(cfg.align, 2)));
+    f.push_back(make_pair("direct_chunk", json_value(cfg.direct_chunk)));
+    f.push_back(make_pair("memory_budget", json_value(cfg.memory_budget)));
+    f.push_back(make_pair("file_type", 
+                json_string(element_type_name(cfg.file_type))));
+    f.push_back(make_pair("memory_type", 
+                json_string(element_type_name(cfg.memory_type))));
+    f.push_back(make_pair("own_conversion", json_value(cfg.own_conversion)));
+    f.push_back(make_pair("type_scale", json_value(cfg.type_scale)));
+    f.push_back(make_pair("halo", json_value(cfg.halo)));
+    f.push_back(make_pair("halo_pack", json_value(cfg.halo_pack)));
+    string split = string(cfg.split[0]) + ";" + cfg.split[1] + ";" + cfg.split[2];
+    f.push_back(make_pair("split", json_string(split == ";;" ? "" : split.c_str())));
+    f.push_back(make_pair("imbalance", json_value(cfg.imbalance)));
+    f.push_back(make_pair("imbalance_seed", json_value(cfg.imbalance_seed)));
+    f.push_back(make_pair("file_groups", cfg.file_groups >= 0 ? 
+                json_value(cfg.file_groups) : 
+                json_string(cfg.file_groups == -1 ? "process" : "node")));
+    f.push_back(make_pair("subfiling", json_value(cfg.subfiling)));
+    f.push_back(make_pair("subfiling_stripe_size", 
+                json_value(cfg.subfiling_stripe_size)));
+    f.push_back(make_pair("subfiling_ioc", json_string(cfg.subfiling_ioc)));
+    return f;
+}
+
+// 16 hex digits of the digest of the parameters not at their defaults
+string results_config_hash(const vector<pair<string, string> >& config)
+{
+    string canonical;
+    for (size_t i = 0; i < config.size(); i++)
+    {
+        const string& value = config[i].second;
+        if (value == "\"\"" || value == "\"f32\"" || 
+                value.find_first_not_of("[0, ]") == string::npos) 
+            continue;
+        canonical += config[i].first + "=" + value + "\n";
+    }
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) 
+            seism_core_digest(canonical.data(), canonical.size()));
+    return hash;
+}
+
+// library versions and the hints given to MPI-IO
+string results_environment(MPI_Info info)
+{
+    unsigned majnum, minnum, relnum;
+    H5get_libversion(&majnum, &minnum, &relnum);
+    ostringstream hdf5;
+    hdf5 << majnum << "." << minnum << "." << relnum;
+
+    char mpi_library[MPI_MAX_LIBRARY_VERSION_STRING];
+    int length = 0;
+    MPI_Get_library_version(mpi_library, &length);
+    mpi_library[strcspn(mpi_library, "\n")] = 0;   // first line only
+    int mpi_version, mpi_subversion;
+    MPI_Get_version(&mpi_version, &mpi_subversion);
+
+    string environment = "{\"hdf5\": " + json_string(hdf5.str().c_str()) 
+        + ", \"mpi\": " + json_string(mpi_library) 
+        + ", \"mpi_standard\": \"" + json_value(mpi_version) + "." 
+        + json_value(mpi_subversion) + "\", \"hints\": {";
+    int n_keys = 0;
+    if (info != MPI_INFO_NULL) MPI_Info_get_nkeys(info, &n_keys);
+    bool first = true;
+    for (int i = 0; i < n_keys; i++)
+    {
+        char key[MPI_MAX_INFO_KEY + 1], value[MPI_MAX_INFO_VAL + 1];
+        int flag = 0;
+        MPI_Info_get_nthkey(info, i, key);
+        MPI_Info_get(info, key, MPI_MAX_INFO_VAL, value, &flag);
+        if (!flag) continue;
+        environment += (first ? "" : ", ") + json_string(key) + ": " 
+            + json_string(value);
+        first = false;
+    }
+    return environment + "}}";
+}
+
+// the number after "key": in a line of JSON, or -1
+double json_number(const string& line, const string& key)
+{
+    size_t at = line.find("\"" + key + "\": ");
+    if (at == string::npos) return -1.0;
+    return atof(line.c_str() + at + key.size() + 4);
+}
+
+// step write times and write phases of every run of config_hash in the store
+int load_baseline
+(
+    const char*     results_file,
+    const string&   config_hash,
+    vector<double>& step_times,
+    vector<double>& write_times
+)
+{
+    ifstream store(results_file);
+    string line;
+    int n_runs = 0;
+    while (getline(store, line))
+    {
+        if (line.find("\"config_hash\": \"" + config_hash + "\"") == string::npos)
+            continue;
+        n_runs++;
+        write_times.push_back(json_number(line, "write"));
+        size_t at = line.find("\"step_write_times\": [");
+        if (at == string::npos) continue;
+        istringstream array(line.substr(at + 21, line.find(']', at) - at - 21));
+        string value;
+        while (getline(array, value, ',')) step_times.push_back(atof(value.c_str()));
+    }
+    return n_runs;
+}
+
+double median(vector<double> values)
+{
+    sort(values.begin(), values.end());
+    size_t n = values.size();
+    if (!n) return 0.0;
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+// one-sided p-value of the values in b tending to be larger than those in a:
+// Mann-Whitney U, normal approximation with continuity and tie corrections
+double mann_whitney_greater(const vector<double>& a, const vector<double>& b)
+{
+    const double n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    if (!n1 || !n2) return 1.0;
+    vector<pair<double, int> > all;
+    for (size_t i = 0; i < a.size(); i++) all.push_back(make_pair(a[i], 0));
+    for (size_t i = 0; i < b.size(); i++) all.push_back(make_pair(b[i], 1));
+    sort(all.begin(), all.end());
+    double rank_sum = 0.0, ties = 0.0;
+    for (size_t i = 0; i < all.size(); )
+    {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) j++;
+        double t = j - i, rank = 0.5 * (i + 1 + j);    // average of i+1..j
+        for (size_t k = i; k < j; k++) if (all[k].second) rank_sum += rank;
+        ties += t * t * t - t;
+        i = j;
+    }
+    double u = rank_sum - n2 * (n2 + 1) / 2;
+    double variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if (variance <= 0.0) return 1.0;
+    double z = (u - n1 * n2 / 2 - 0.5) / sqrt(variance);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+// prints the comparison, returns true for a significant slowdown
+bool compare_with_baseline
+(
+    const seism_core_config& cfg,
+    const string&            config_hash,
+    const vector<double>&    step_times,
+    double                   write_time
+)
+{
+    vector<double> baseline_steps, baseline_writes;
+    int n_runs = load_baseline(cfg.compare_results, config_hash, 
+            baseline_steps, baseline_writes);
+    if (!n_runs)
+    {
+        cout << "Baseline runs:\t\t\tnone with config " << config_hash << endl;
+        return false;
+    }
+    double now = median(step_times), then = median(baseline_steps);
+    double p = mann_whitney_greater(baseline_steps, step_times);
+    bool slower = now > then * (1.0 + cfg.compare_threshold / 100.0) 
+        && p < cfg.compare_alpha;
+    cout << "Baseline runs:\t\t\t" << n_runs << " with config " << config_hash 
+         << " (" << baseline_steps.size() << " steps)" << endl;
+    cout << "Write phase:\t\t\t" << write_time << " s, baseline median " 
+         << median(baseline_writes) << " s" << endl;
+    cout << "Step write median:\t\t" << now << " s, baseline " << then << " s";
+    if (then > 0.0) cout << " (" << showpos << 100.0 * (now / then - 1.0) 
+                         << noshowpos << " %)";
+    cout << endl;
+    cout << "Slowdown p-value:\t\t" << p << (slower ? 
+            "\tSLOWER than the baseline" : "\tno slowdown") << endl;
+    return slower;
+}
+
+// one line of JSON per case
+void append_result
+(
+    const seism_core_config&                     cfg,
+    const vector<pair<string, string> >&         config,
+    const string&                                config_hash,
+    const string&                                environment,
+    const seism_core_result&                     result,
+    double                                       fill_time,
+    const vector<double>&                        step_times
+)
+{
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    ofstream store(cfg.results_file, ios::app);
+    store << "{\"time\": \"" << stamp << "\", \"config_hash\": \"" 
+          << config_hash << "\", \"config\": {";
+    for (size_t i = 0; i < config.size(); i++)
+        store << (i ? ", " : "") << "\"" << config[i].first << "\": " 
+              << config[i].second;
+    store << "}, \"environment\": " << environment 
+          << ", \"phases\": {\"create\": " << result.create_time
+          << ", \"fill\": " << fill_time
+          << ", \"write\": " << result.write_time
+          << ", \"close\": " << result.close_time
+          << ", \"write_throughput\": " << result.write_throughput
+          << ", \"aggregate_throughput\": " << result.aggregate_throughput
+          << ", \"storage_size\": " << result.storage_size
+          << ", \"compression_ratio\": " << result.compression_ratio
+          << "}, \"step_write_times\": " 
+          << json_array(step_times.data(), step_times.size()) << "}" << endl;
+    cout << "Results appended to:\t\t" << cfg.results_file << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// I/O forwarding: the last io_servers ranks only write. Server s owns the 
+// rows of blocks [first_row(s), first_row(s + 1)) along the first axis, i.e.
+// one slab of the file spanning the whole of the other two axes, and the
+// compute ranks (clients) of those rows send it their blocks every timestep.
+
+hsize_t forwarding_first_row(int server, hsize_t n_rows, int io_servers)
+{
+    return (hsize_t) server * n_rows / io_servers;
+}
+
+int forwarding_server(hsize_t row, hsize_t n_rows, int io_servers)
+{
+    return (int) (((row + 1) * io_servers - 1) / n_rows);
+}
+
+void block_of_rank(int rank, const hsize_t* processor, hsize_t* number)
+{
+    number[2] = (hsize_t) rank % processor[2];
+    number[1] = (hsize_t) (rank / processor[2]) % processor[1];
+    number[0] = (hsize_t) (rank / processor[2]) / processor[1];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Client side: compute, hand the block to the server and go on computing.
+// The time spent in MPI is what the application stalls for I/O.
+
+void forward_timesteps
+(
+    const seism_core_config& cfg,
+    MPI_Comm                 comm,
+    const vector<float>&     v,
+    int                      server_rank,
+    vector<double>&          step_time,     // stall per timestep
+    vector<uint64_t>&        digests,
+    double&                  compute_total,
+    double&                  digest_total
+)
+{
+    int mpi_retval = 0;
+    bool emulate_compute = (cfg.compute_time > 0.0);
+    vector<float> state[2];
+    if (emulate_compute) 
+    {
+        state[0].resize(v.size());
+        state[1].resize(v.size());
+    }
+    MPI_Request request[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+
+    for (size_t it = 0; it < cfg.simulation_time; ++it)
+    {
+        int b = it % 2;
+        const float* buf = &v[0];
+        if (emulate_compute)
+        {
+            // the send from this buffer two steps ago has to be done first
+            double t0 = MPI_Wtime();
+            mpi_retval = MPI_Wait(&request[b], MPI_STATUS_IGNORE);
+            assert(mpi_retval == MPI_SUCCESS);
+            step_time[it] += MPI_Wtime() - t0;
+            compute_total += compute_phase(state[b], v, cfg.compute_time);
+            buf = &state[b][0];
+        }
+        if (cfg.digest)
+        {
+            double t0 = MPI_Wtime();
+            digests[it] = seism_core_digest(buf, v.size() * sizeof(float));
+            digest_total += MPI_Wtime() - t0;
+        }
+
+        double t0 = MPI_Wtime();
+        if (!emulate_compute && request[b] != MPI_REQUEST_NULL)
+        {
+            mpi_retval = MPI_Wait(&request[b], MPI_STATUS_IGNORE);
+            assert(mpi_retval == MPI_SUCCESS);
+        }
+        mpi_retval = MPI_Isend(buf, v.size(), MPI_FLOAT, server_rank, it, 
+                comm, &request[b]);
+        assert(mpi_retval == MPI_SUCCESS);
+        step_time[it] += MPI_Wtime() - t0;
+    }
+
+    double t0 = MPI_Wtime();
+    mpi_retval = MPI_Waitall(2, request, MPI_STATUSES_IGNORE);
+    assert(mpi_retval == MPI_SUCCESS);
+    step_time[cfg.simulation_time - 1] += MPI_Wtime() - t0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Server side: receive the blocks of a timestep straight into place in the
+// slab, then write the slab with one H5Dwrite(). The receives for the next
+// timestep are already posted while this one is written.
+
+void serve_timesteps
+(
+    const seism_core_config& cfg,
+    MPI_Comm                 comm,
+    hid_t                    dset,
+    hid_t                    dxpl,
+    int                      server,
+    const vector<int>&       clients,
+    vector<double>&          step_time,     // H5Dwrite() per timestep
+    vector<double>&          extend_time,   // H5Dset_extent() per timestep
+    double&                  receive_total
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    int mpi_retval = 0;
+    hsize_t first_row = forwarding_first_row(server, cfg.processor[0], cfg.io_servers);
+    hsize_t n_rows = forwarding_first_row(server + 1, cfg.processor[0], 
+            cfg.io_servers) - first_row;
+
+    // where each client's block goes in the slab
+    int slab_dims[3] = {(int) (n_rows * cfg.domain[0]), 
+        (int) (cfg.processor[1] * cfg.domain[1]), 
+        (int) (cfg.processor[2] * cfg.domain[2])};
+    int block_dims[3] = {(int) cfg.domain[0], (int) cfg.domain[1], 
+        (int) cfg.domain[2]};
+    vector<MPI_Datatype> placement(clients.size());
+    for (size_t c = 0; c < clients.size(); c++)
+    {
+        hsize_t number[3];
+        block_of_rank(clients[c], cfg.processor, number);
+        int offset[3] = {(int) ((number[0] - first_row) * cfg.domain[0]), 
+            (int) (number[1] * cfg.domain[1]), (int) (number[2] * cfg.domain[2])};
+        mpi_retval = MPI_Type_create_subarray(3, slab_dims, block_dims, offset, 
+                MPI_ORDER_C, MPI_FLOAT, &placement[c]);
+        assert(mpi_retval == MPI_SUCCESS);
+        mpi_retval = MPI_Type_commit(&placement[c]);
+        assert(mpi_retval == MPI_SUCCESS);
+    }
+
+    size_t slab_size = (size_t) slab_dims[0] * slab_dims[1] * slab_dims[2];
+    vector<float> slab[2];
+    slab[0].resize(slab_size);
+    slab[1].resize(slab_size);
+    vector<MPI_Request> requests[2];
+
+    hsize_t mdims[4] = {1, (hsize_t) slab_dims[0], (hsize_t) slab_dims[1], 
+        (hsize_t) slab_dims[2]};
+    hid_t mspace = H5Screate_simple(4, mdims, NULL);
+    assert(mspace >= 0);
+    hid_t fspace = H5Dget_space(dset);
+    assert(fspace >= 0);
+    hsize_t start[4] = {0, first_row * cfg.domain[0], 0, 0};
+    hsize_t count[4] = {1, 1, 1, 1};
+
+    for (size_t it = 0; it <= cfg.simulation_time; ++it)
+    {
+        // post the receives for this step, then write the previous one
+        int b = it % 2;
+        if (it < cfg.simulation_time)
+        {
+            requests[b].assign(clients.size(), MPI_REQUEST_NULL);
+            for (size_t c = 0; c < clients.size(); c++)
+            {
+                mpi_retval = MPI_Irecv(&slab[b][0], 1, placement[c], clients[c], 
+                        it, comm, &requests[b][c]);
+                assert(mpi_retval == MPI_SUCCESS);
+            }
+        }
+        if (it == 0) continue;
+
+        int p = 1 - b;
+        double t0 = MPI_Wtime();
+        mpi_retval = MPI_Waitall(requests[p].size(), &requests[p][0], 
+                MPI_STATUSES_IGNORE);
+        assert(mpi_retval == MPI_SUCCESS);
+        receive_total += MPI_Wtime() - t0;
+
+        if (cfg.extend_time) 
+            extend_time[it - 1] = extend_time_dimension(&dset, 1, fspace, it);
+        start[0] = it - 1;
+        herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, NULL, 
+                count, mdims);
+        assert(herr_retval >= 0);
+        t0 = MPI_Wtime();
+        herr_retval = H5Dwrite(dset, H5T_NATIVE_FLOAT, mspace, fspace, dxpl, 
+                &slab[p][0]);
+        assert(herr_retval >= 0);
+        step_time[it - 1] = MPI_Wtime() - t0;
+    }
+
+    for (size_t c = 0; c < clients.size(); c++) MPI_Type_free(&placement[c]);
+    H5Sclose(fspace);
+    H5Sclose(mspace);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Node aggregation: the ranks of a node put their blocks in an MPI shared
+// memory window, and the node leader writes all of them with one H5Dwrite().
+// The leader copies the blocks out of the window in file order first, so 
+// that the rest of the node can go on as soon as that is done.
+
+struct node_copy
+{
+    int    segment;    // node rank owning the block
+    size_t offset;     // in the segment
+    size_t length;     // elements
+};
+
+// The runs to copy, in the order in which HDF5 walks the union of the 
+// node's blocks: by x, then y, then z, across the blocks.
+vector<node_copy> plan_node_copies
+(
+    const vector<hsize_t>& block_numbers,  // three per node rank
+    const hsize_t*         domain
+)
+{
+    size_t n_blocks = block_numbers.size() / 3;
+    vector<size_t> order(n_blocks);
+    for (size_t b = 0; b < n_blocks; b++) order[b] = b;
+    sort(order.begin(), order.end(), [&block_numbers](size_t a, size_t b) {
+            return lexicographical_compare(&block_numbers[3 * a], &block_numbers[3 * a + 3],
+                &block_numbers[3 * b], &block_numbers[3 * b + 3]); });
+
+    vector<node_copy> copies;
+    size_t i = 0;
+    while (i < n_blocks)
+    {
+        // all blocks with the same x block number
+        size_t j = i;
+        while (j < n_blocks && block_numbers[3 * order[j]] == block_numbers[3 * order[i]]) j++;
+        for (hsize_t x = 0; x < domain[0]; x++)
+        {
+            size_t k = i;
+            while (k < j)
+            {
+                // all of those with the same y block number, in z order
+                size_t l = k;
+                while (l < j && block_numbers[3 * order[l] + 1] == block_numbers[3 * order[k] + 1]) l++;
+                for (hsize_t y = 0; y < domain[1]; y++)
+                    for (size_t b = k; b < l; b++)
+                    {
+                        node_copy c = {(int) order[b], 
+                            (size_t) ((x * domain[1] + y) * domain[2]), 
+                            (size_t) domain[2]};
+                        copies.push_back(c);
+                    }
+                k = l;
+            }
+        }
+        i = j;
+    }
+    return copies;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Every rank: compute, put the block in the window and wait until the leader
+// has taken it. The leader also writes, and its step_time is H5Dwrite() only.
+
+void aggregate_timesteps
+(
+    const seism_core_config& cfg,
+    const vector<float>&     v,
+    MPI_Comm                 node_comm,
+    hid_t                    dset,
+    hid_t                    dxpl,
+    vector<double>&          step_time,
+    vector<double>&          extend_time,   // leader: H5Dset_extent()
+    vector<uint64_t>&        digests,
+    vector<hsize_t>&         node_blocks,   // leader: those of the node
+    double&                  compute_total,
+    double&                  digest_total,
+    double&                  stall_total,   // copy in and waiting
+    double&                  pack_total     // leader: copy out
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    int mpi_retval = 0;
+    int node_rank, node_size;
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_size(node_comm, &node_size);
+    bool leader = (node_rank == 0);
+
+    float* segment = NULL;
+    MPI_Win win;
+    mpi_retval = MPI_Win_allocate_shared(v.size() * sizeof(float), sizeof(float), 
+            MPI_INFO_NULL, node_comm, &segment, &win);
+    assert(mpi_retval == MPI_SUCCESS);
+    mpi_retval = MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+    assert(mpi_retval == MPI_SUCCESS);
+
+    // the leader finds everybody's segment and plans the copies
+    vector<float*> segments(node_size, (float*) NULL);
+    vector<node_copy> copies;
+    vector<float> staging;
+    hid_t mspace = H5I_INVALID_HID, fspace = H5I_INVALID_HID;
+    if (leader)
+    {
+        for (int r = 0; r < node_size; r++)
+        {
+            MPI_Aint size;
+            int disp_unit;
+            mpi_retval = MPI_Win_shared_query(win, r, &size, &disp_unit, &segments[r]);
+            assert(mpi_retval == MPI_SUCCESS);
+        }
+        copies = plan_node_copies(node_blocks, cfg.domain);
+        staging.resize((size_t) node_size * v.size());
+        hsize_t mdims[1] = {staging.size()};
+        mspace = H5Screate_simple(1, mdims, NULL);
+        assert(mspace >= 0);
+        fspace = H5Dget_space(dset);
+        assert(fspace >= 0);
+    }
+
+    vector<float> state;
+    if (cfg.compute_time > 0.0) state.resize(v.size());
+    hsize_t count[4] = {1, 1, 1, 1};
+    hsize_t block[4] = {1, cfg.domain[0], cfg.domain[1], cfg.domain[2]};
+
+    for (size_t it = 0; it < cfg.simulation_time; ++it)
+    {
+        const float* buf = &v[0];
+        if (cfg.compute_time > 0.0)
+        {
+            compute_total += compute_phase(state, v, cfg.compute_time);
+            buf = &state[0];
+        }
+        if (cfg.digest)
+        {
+            double t0 = MPI_Wtime();
+            digests[it] = seism_core_digest(buf, v.size() * sizeof(float));
+            digest_total += MPI_Wtime() - t0;
+        }
+
+        double t0 = MPI_Wtime();
+        copy(buf, buf + v.size(), segment);
+        MPI_Win_sync(win);
+        MPI_Barrier(node_comm);     // all blocks are in
+        MPI_Win_sync(win);
+        if (leader)
+        {
+            double t1 = MPI_Wtime();
+            float* out = &staging[0];
+            for (size_t c = 0; c < copies.size(); c++)
+            {
+                const float* in = segments[copies[c].segment] + copies[c].offset;
+                out = copy(in, in + copies[c].length, out);
+            }
+            pack_total += MPI_Wtime() - t1;
+        }
+        MPI_Barrier(node_comm);     // the window may be reused
+        stall_total += MPI_Wtime() - t0;
+
+        if (leader)
+        {
+            if (cfg.extend_time) 
+                extend_time[it] = extend_time_dimension(&dset, 1, fspace, it + 1);
+            herr_retval = H5Sselect_none(fspace);
+            assert(herr_retval >= 0);
+            for (int r = 0; r < node_size; r++)
+            {
+                hsize_t start[4] = {it, node_blocks[3 * r] * cfg.domain[0], 
+                    node_blocks[3 * r + 1] * cfg.domain[1], 
+                    node_blocks[3 * r + 2] * cfg.domain[2]};
+                herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_OR, start, 
+                        NULL, count, block);
+                assert(herr_retval >= 0);
+            }
+            double t1 = MPI_Wtime();
+            herr_retval = H5Dwrite(dset, H5T_NATIVE_FLOAT, mspace, fspace, dxpl, 
+                    &staging[0]);
+            assert(herr_retval >= 0);
+            step_time[it] = MPI_Wtime() - t1;
+        }
+    }
+
+    if (leader)
+    {
+        H5Sclose(fspace);
+        H5Sclose(mspace);
+    }
+    mpi_retval = MPI_Win_unlock_all(win);
+    assert(mpi_retval == MPI_SUCCESS);
+    mpi_retval = MPI_Win_free(&win);
+    assert(mpi_retval == MPI_SUCCESS);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Metadata cache, file space and metadata aggregation settings. The file 
+// creation properties go in fcpl, the rest in fapl. Returns false if the 
+// library refused evict_on_close, which parallel HDF5 does not support.
+
+bool set_metadata_tuning
+(
+    const seism_core_config& cfg,
+    hid_t                    fcpl,
+    hid_t                    fapl
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    bool evict_on_close_set = true;
+
+    if (cfg.mdc_size[0] || cfg.mdc_no_evictions)
+    {
+        H5AC_cache_config_t mdc;
+        mdc.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+        herr_retval = H5Pget_mdc_config(fapl, &mdc);
+        assert(herr_retval >= 0);
+        if (cfg.mdc_size[0])
+        {
+            mdc.set_initial_size = 1;
+            mdc.initial_size = cfg.mdc_size[0];
+            mdc.min_size = cfg.mdc_size[1];
+            mdc.max_size = cfg.mdc_size[2];
+        }
+        if (cfg.mdc_no_evictions)
+        {
+            // the cache may then not be resized either
+            mdc.evictions_enabled = 0;
+            mdc.incr_mode = H5C_incr__off;
+            mdc.flash_incr_mode = H5C_flash_incr__off;
+            mdc.decr_mode = H5C_decr__off;
+        }
+        herr_retval = H5Pset_mdc_config(fapl, &mdc);
+        assert(herr_retval >= 0);
+    }
+
+    if (cfg.file_space_strategy[0])
+    {
+        H5F_fspace_strategy_t strategy = H5F_FSPACE_STRATEGY_FSM_AGGR;
+        if (!strcmp(cfg.file_space_strategy, "page")) 
+            strategy = H5F_FSPACE_STRATEGY_PAGE;
+        else if (!strcmp(cfg.file_space_strategy, "aggr")) 
+            strategy = H5F_FSPACE_STRATEGY_AGGR;
+        else if (!strcmp(cfg.file_space_strategy, "none")) 
+            strategy = H5F_FSPACE_STRATEGY_NONE;
+        herr_retval = H5Pset_file_space_strategy(fcpl, strategy, 
+                cfg.file_space_persist, 1);
+        assert(herr_retval >= 0);
+    }
+    if (cfg.file_space_page_size)
+    {
+        herr_retval = H5Pset_file_space_page_size(fcpl, cfg.file_space_page_size);
+        assert(herr_retval >= 0);
+    }
+
+    if (cfg.meta_block_size)
+    {
+        herr_retval = H5Pset_meta_block_size(fapl, cfg.meta_block_size);
+        assert(herr_retval >= 0);
+    }
+    if (cfg.coll_metadata_write)
+    {
+        herr_retval = H5Pset_coll_metadata_write(fapl, true);
+        assert(herr_retval >= 0);
+    }
+    if (cfg.evict_on_close)
+    {
+        H5E_BEGIN_TRY {
+            herr_retval = H5Pset_evict_on_close(fapl, true);
+        } H5E_END_TRY;
+        evict_on_close_set = (herr_retval >= 0);
+    }
+    return evict_on_close_set;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The fill plugin, loaded for this rank's block. Rows of the block can be 
+// filled in any number of calls, which is what lets streaming writes make 
+// every slab when it is needed rather than hold the whole block.
+
+struct block_fill
+{
+    void*                         handle;
+    const seism_core_fill_plugin* plugin;
+    void*                         state;
+    float (*use_function)(int, hsize_t*, hsize_t*, hsize_t*, hsize_t*, int, 
+            char **);
+    int                           mpi_rank;
+    hsize_t*                      system_size;
+    hsize_t*                      block_size;
+    hsize_t*                      block_number;
+    int                           argc;
+    char                          use_function_argv[256];
+    const char*                   array[16];
+    double                        init_time;      // of the block ABI's init()
+    size_t                        shared_bytes;   // mapped, shared on the node
+};
+
+void open_block_fill
+(
+    block_fill&         f,
+    seism_core_config&  cfg,
+    int                 mpi_rank,
+    hsize_t*            domain_block_number
+)
+{
+    char *error;
+
+    f.handle = dlopen (cfg.use_function_lib, RTLD_LAZY);
+    if (!f.handle) {
+        fputs (dlerror(), stderr);
+        exit(1);
+    }
+
+    // split use_function_argv into tokens, then pass to library function;
+    // tokenize a copy, the original is recorded in the attributes
+    strcpy(f.use_function_argv, cfg.use_function_argv);
+    for (int i = 0; i < cfg.use_function_argc; i++) {
+        if (i == 0) f.array[i] = strtok(f.use_function_argv, " ");
+        else f.array[i] = strtok(NULL, " ");
+    }   
+    f.mpi_rank = mpi_rank;
+    f.system_size = cfg.processor;
+    f.block_size = cfg.domain;
+    f.block_number = domain_block_number;
+    f.argc = cfg.use_function_argc;
+
+    // prefer the block ABI, <name>_plugin, see seism-core-plugin.h
+    string plugin_name = string(cfg.use_function_name) + "_plugin";
+    f.plugin = (const seism_core_fill_plugin*) dlsym(f.handle, plugin_name.c_str());
+    dlerror(); // not finding it is fine
+    if (f.plugin && (f.plugin->abi_version < SEISM_CORE_PLUGIN_ABI_MIN_VERSION
+                || f.plugin->abi_version > SEISM_CORE_PLUGIN_ABI_VERSION))
+    {
+        if (mpi_rank==0) printf("%s has ABI version %d, expected %d to %d; "
+                "using per-element %s instead.\n", plugin_name.c_str(), 
+                f.plugin->abi_version, SEISM_CORE_PLUGIN_ABI_MIN_VERSION,
+                SEISM_CORE_PLUGIN_ABI_VERSION, cfg.use_function_name);
+        f.plugin = NULL;
+    }
+
+    f.init_time = 0.0;
+    f.shared_bytes = 0;
+    if (f.plugin)
+    {
+        seism_core_fill_args args = {mpi_rank, cfg.processor, cfg.domain,
+            domain_block_number, cfg.use_function_argc, (char **)f.array};
+        f.state = NULL;
+        double start_init = MPI_Wtime();
+        if (f.plugin->init(&args, &f.state) != 0)
+        {
+            fprintf(stderr, "%s: init failed\n", plugin_name.c_str());
+            exit(1);
+        }
+        f.init_time = MPI_Wtime() - start_init;
+        // version 1 descriptors end at finalize
+        if (f.plugin->abi_version >= 2 && f.plugin->shared_bytes)
+            f.shared_bytes = f.plugin->shared_bytes(f.state);
+    }
+    else
+    {
+        // per-element compatibility path
+        // This awkward cast provided to you by the ISO standards team...
+        *(void **) (&f.use_function) = dlsym(f.handle, cfg.use_function_name);
+        if ((error = dlerror()) != NULL)  {
+            fputs(error, stderr);
+            exit(1);
+        }
+    }
+}
+
+// rows [row_begin, row_end) of the block, into buffer
+void fill_rows(block_fill& f, hsize_t row_begin, hsize_t row_end, float* buffer)
+{
+    if (f.plugin)
+    {
+        f.plugin->fill(f.state, row_begin, row_end, buffer);
+        return;
+    }
+    hsize_t* domain = f.block_size;
+    hsize_t position_in_block[3];
+    for (position_in_block[0] = row_begin; position_in_block[0] < row_end; position_in_block[0]++)
+    for (position_in_block[1] = 0; position_in_block[1] < domain[1]; position_in_block[1]++)
+    for (position_in_block[2] = 0; position_in_block[2] < domain[2]; position_in_block[2]++)
+    {
+        hsize_t index = (position_in_block[0] - row_begin) * domain[1] * domain[2] + position_in_block[1] * domain[2] + position_in_block[2];
+        buffer[index] = (*f.use_function)(f.mpi_rank, f.system_size, domain, f.block_number, position_in_block, f.argc, (char **)f.array);
+    }
+}
+
+void close_block_fill(block_fill& f)
+{
+    if (f.plugin) f.plugin->finalize(f.state);
+    dlclose(f.handle);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The filter chain, in the order of filter_stages(). A stage is a filter name
+// and its parameters, or a registered filter id and its cd_values.
+
+// IEEE single precision with the mantissa cut to bits - 9 bits, stored by 
+// the n-bit filter in bits bits per value
+hid_t reduced_float_type(unsigned bits)
+{
+    herr_t herr_retval = (herr_t) 0;
+    size_t mantissa = bits - 9, offset = 23 - mantissa;
+    hid_t type = H5Tcopy(H5T_IEEE_F32LE);
+    assert(type >= 0);
+    herr_retval = H5Tset_fields(type, 31, 23, 8, offset, mantissa);
+    assert(herr_retval >= 0);
+    herr_retval = H5Tset_offset(type, offset);
+    assert(herr_retval >= 0);
+    herr_retval = H5Tset_precision(type, bits);
+    assert(herr_retval >= 0);
+    herr_retval = H5Tset_size(type, 4);
+    assert(herr_retval >= 0);
+    return type;
+}
+
+// Add one stage to dcpl. The n-bit filter also replaces the file type, 
+// which the caller closes. Returns false for unknown or unavailable filters.
+bool set_filter
+(
+    const string& stage,
+    hid_t         dcpl,
+    hid_t&        file_type
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    istringstream iss(stage);
+    string name;
+    iss >> name;
+    if (!name.compare("shuffle"))
+        herr_retval = H5Pset_shuffle(dcpl);
+    else if (!name.compare("fletcher32"))
+        herr_retval = H5Pset_fletcher32(dcpl);
+    else if (!name.compare("deflate"))
+    {
+        unsigned level = 6;
+        iss >> level;
+        herr_retval = H5Pset_deflate(dcpl, level);
+    }
+    else if (!name.compare("scaleoffset"))
+    {
+        // decimal digits kept after the point
+        int digits = 3;
+        iss >> digits;
+        herr_retval = H5Pset_scaleoffset(dcpl, H5Z_SO_FLOAT_DSCALE, digits);
+    }
+    else if (!name.compare("nbit"))
+    {
+        unsigned bits = 16;
+        iss >> bits;
+        if (bits < 10 || bits > 32) return false;
+        file_type = reduced_float_type(bits);
+        herr_retval = H5Pset_nbit(dcpl);
+    }
+    else if (!name.compare("zfp"))
+    {
+#ifdef INCLUDE_ZFP
+        string mode;
+        iss >> mode;
+        if (mode.empty())
+        {
+            // what "zfp" has always meant
+            size_t cd_nelmts = 4;
+            unsigned int cd_values[] = {3, 0, 0, 0};
+            herr_retval = H5Pset_filter(dcpl, H5Z_FILTER_ZFP, 
+                    H5Z_FLAG_MANDATORY, cd_nelmts, cd_values);
+        }
+        else if (!mode.compare("rate"))
+        {
+            double rate = 16.0;
+            iss >> rate;
+            herr_retval = H5Pset_zfp_rate(dcpl, rate);
+        }
+        else if (!mode.compare("precision"))
+        {
+            unsigned precision = 20;
+            iss >> precision;
+            herr_retval = H5Pset_zfp_precision(dcpl, precision);
+        }
+        else if (!mode.compare("accuracy"))
+        {
+            double accuracy = 1.0e-3;
+            iss >> accuracy;
+            herr_retval = H5Pset_zfp_accuracy(dcpl, accuracy);
+        }
+        else if (!mode.compare("reversible"))
+            herr_retval = H5Pset_zfp_reversible(dcpl);
+        else return false;
+#else
+        return false;
+#endif
+    }
+    else if (name.find_first_not_of("0123456789") == string::npos)
+    {
+        // any registered filter, e.g. a plugin found via HDF5_PLUGIN_PATH
+        H5Z_filter_t id = (H5Z_filter_t) atoi(name.c_str());
+        vector<unsigned int> cd_values;
+        unsigned int value;
+        while (iss >> value) cd_values.push_back(value);
+        herr_retval = H5Pset_filter(dcpl, id, H5Z_FLAG_MANDATORY, 
+                cd_values.size(), cd_values.empty() ? NULL : &cd_values[0]);
+    }
+    else return false;
+    return herr_retval >= 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Measure the first n_stages filters of the chain on this rank's block, in a
+// file in memory (core driver, no backing store), so that the file system
+// doesn't count. The chunk cache is off, so every chunk passes through the
+// pipeline on the way in and on the way out.
+
+struct filter_benchmark
+{
+    double raw_bytes;
+    double stored_bytes;
+    double compress_time;
+    double decompress_time;
+};
+
+filter_benchmark benchmark_filters
+(
+    const vector<string>& stages,
+    size_t                n_stages,
+    const hsize_t*        chunk,
+    const hsize_t*        domain,
+    int                   element_type,
+    const vector<float>&  v,
+    vector<float>&        read_back
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    filter_benchmark fb;
+
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    assert(fapl >= 0);
+    herr_retval = H5Pset_fapl_core(fapl, 1 << 20, 0);
+    assert(herr_retval >= 0);
+    hid_t file = H5Fcreate("seism-core-filters.h5", H5F_ACC_TRUNC, H5P_DEFAULT,
+            fapl);
+    assert(file >= 0);
+
+    hsize_t dims[4] = {1, domain[0], domain[1], domain[2]};
+    hsize_t cdims[4] = {1, min(chunk[0], domain[0]), min(chunk[1], domain[1]),
+        min(chunk[2], domain[2])};
+    hid_t space = H5Screate_simple(4, dims, NULL);
+    assert(space >= 0);
+    hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    assert(dcpl >= 0);
+    herr_retval = H5Pset_chunk(dcpl, 4, cdims);
+    assert(herr_retval >= 0);
+    hid_t element_file_type = element_hdf5_type(element_type, true);
+    hid_t file_type = element_file_type;
+    for (size_t i = 0; i < n_stages; i++)
+    {
+        bool filter_set = set_filter(stages[i], dcpl, file_type);
+        assert(filter_set);
+    }
+    hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
+    assert(dapl >= 0);
+    herr_retval = H5Pset_chunk_cache(dapl, 0, 0, 1.0);
+    assert(herr_retval >= 0);
+    hid_t dset = H5Dcreate(file, "block", file_type, space, H5P_DEFAULT, dcpl, 
+            dapl);
+    assert(dset >= 0);
+
+    double t0 = MPI_Wtime();
+    herr_retval = H5Dwrite(dset, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, 
+            H5P_DEFAULT, &v[0]);
+    assert(herr_retval >= 0);
+    fb.compress_time = MPI_Wtime() - t0;
+    fb.raw_bytes = v.size() * element_size(element_type);
+    fb.stored_bytes = H5Dget_storage_size(dset);
+
+    read_back.resize(v.size());
+    t0 = MPI_Wtime();
+    herr_retval = H5Dread(dset, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, 
+            H5P_DEFAULT, &read_back[0]);
+    assert(herr_retval >= 0);
+    fb.decompress_time = MPI_Wtime() - t0;
+
+    H5Dclose(dset);
+    H5Pclose(dapl);
+    H5Pclose(dcpl);
+    if (file_type != element_file_type) H5Tclose(file_type);
+    H5Tclose(element_file_type);
+    H5Sclose(space);
+    H5Fclose(file);
+    H5Pclose(fapl);
+    return fb;
+}
+
+// Converting the block from one element type to the other in memory, with
+// H5Tconvert(), which is what H5Dwrite() does, and with seism-core's loops:
+// the best of three of each, and how many elements they convert differently
+
+struct conversion_benchmark
+{
+    double hdf5_time;
+    double own_time;
+    double differences;
+};
+
+conversion_benchmark benchmark_conversion
+(
+    int         from,
+    int         to,
+    const void* in,
+    size_t      n
+)
+{
+    conversion_benchmark cb = {HUGE_VAL, HUGE_VAL, 0.0};
+    size_t in_size = element_size(from), out_size = element_size(to);
+    // H5Tconvert() converts in place
+    vector<char> hdf5(n * max(in_size, out_size)), own(n * out_size);
+    hid_t src = element_hdf5_type(from, false), dst = element_hdf5_type(to, false);
+    for (int i = 0; i < 3; i++)
+    {
+        memcpy(&hdf5[0], in, n * in_size);
+        double t0 = MPI_Wtime();
+        herr_t herr_retval = H5Tconvert(src, dst, n, &hdf5[0], NULL, H5P_DEFAULT);
+        assert(herr_retval >= 0);
+        cb.hdf5_time = min(cb.hdf5_time, MPI_Wtime() - t0);
+        t0 = MPI_Wtime();
+        convert_elements(from, in, to, &own[0], n);
+        cb.own_time = min(cb.own_time, MPI_Wtime() - t0);
+    }
+    for (size_t i = 0; i < n; i++)
+        if (memcmp(&hdf5[i * out_size], &own[i * out_size], out_size)) 
+            cb.differences++;
+    H5Tclose(src);
+    H5Tclose(dst);
+    return cb;
+}
+
+// Gathering the interior of the padded array into a contiguous buffer in
+// memory, with H5Dgather() on the memory selection, which is how HDF5 walks
+// it, and with pack_interior(): the best of three of each
+
+void benchmark_halo
+(
+    const halo_layout& halo,
+    double*            elapsed          // H5Dgather(), pack_interior()
+)
+{
+    elapsed[0] = elapsed[1] = HUGE_VAL;
+    size_t n = halo.interior[0] * halo.interior[1] * halo.interior[2];
+    vector<float> out(n);
+    for (int i = 0; i < 3; i++)
+    {
+        double t0 = MPI_Wtime();
+        herr_t herr_retval = H5Dgather(halo.mspace, &halo.padded[0], 
+                H5T_NATIVE_FLOAT, n * sizeof(float), &out[0], NULL, NULL);
+        assert(herr_retval >= 0);
+        elapsed[0] = min(elapsed[0], MPI_Wtime() - t0);
+        t0 = MPI_Wtime();
+        pack_interior(halo, &out[0]);
+        elapsed[1] = min(elapsed[1], MPI_Wtime() - t0);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Irregular decompositions: along an axis with a split list its sizes, 
+// which set the global extent; along the others, with an imbalance ratio,
+// random sizes between one and ratio times the smallest, in proportion,
+// that add up to processor times domain. Every rank draws the same sizes
+// from the seed. Exits if the sizes don't fit the process grid.
+
+void random_sizes
+(
+    hsize_t               n,
+    hsize_t               total,
+    double                ratio,
+    unsigned int          seed,
+    vector<hsize_t>&      sizes
+)
+{
+    vector<double> weights(n), remainders(n);
+    double sum = 0.0;
+    for (hsize_t i = 0; i < n; i++)
+    {
+        weights[i] = 1.0 + (ratio - 1.0) * rand_r(&seed) / (double) RAND_MAX;
+        sum += weights[i];
+    }
+    // round down, then hand out what's left to the largest remainders
+    sizes.resize(n);
+    hsize_t assigned = 0;
+    for (hsize_t i = 0; i < n; i++)
+    {
+        double exact = total * weights[i] / sum;
+        sizes[i] = (hsize_t) exact;
+        remainders[i] = exact - sizes[i];
+        assigned += sizes[i];
+    }
+    for (; assigned < total; assigned++)
+    {
+        size_t largest = max_element(remainders.begin(), remainders.end()) -
+            remainders.begin();
+        sizes[largest]++;
+        remainders[largest] = -1.0;
+    }
+}
+
+seism_core_decomposition make_decomposition
+(
+    const seism_core_config& cfg,
+    int                      mpi_rank
+)
+{
+    seism_core_decomposition dec = regular_decomposition(cfg.processor, 
+            cfg.domain);
+    for (int d = 0; d < 3; d++)
+    {
+        if (cfg.split[d][0])
+        {
+            istringstream in(cfg.split[d]);
+            dec.sizes[d].clear();
+            hsize_t size;
+            while (in >> size) dec.sizes[d].push_back(size);
+        }
+        else if (cfg.imbalance > 1.0)
+            random_sizes(cfg.processor[d], cfg.processor[d] * cfg.domain[d],
+                    cfg.imbalance, cfg.imbalance_seed * 3 + d, dec.sizes[d]);
+        bool fits = dec.sizes[d].size() == cfg.processor[d] && 
+            find(dec.sizes[d].begin(), dec.sizes[d].end(), 0) == dec.sizes[d].end();
+        if (!fits)
+        {
+            if (mpi_rank==0) printf("axis %d needs %d block sizes, none of them "
+                    "zero\nExiting.\n", d, (int) cfg.processor[d]);
+            exit(126);
+        }
+    }
+    set_offsets(dec);
+    return dec;
+}
+
+// the spread of a quantity over the ranks, e.g. of the bytes they write
+void report_balance
+(
+    const char*           label,
+    const vector<double>& per_rank,
+    const char*           unit
+)
+{
+    double low = *min_element(per_rank.begin(), per_rank.end());
+    double high = *max_element(per_rank.begin(), per_rank.end());
+    double mean = 0.0;
+    for (size_t r = 0; r < per_rank.size(); r++) mean += per_rank[r];
+    mean /= per_rank.size();
+    cout << label << "min " << low << ", mean " << mean << ", max " << high 
+         << unit << " (max/mean " << (mean > 0.0 ? high / mean : 1.0) << ")" 
+         << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Piece files: with file_groups the ranks are grouped, every group writes a
+// file of its own, and process 0 stitches them together in the output file 
+// with a virtual dataset per variable. A piece file holds the bounding box of
+// its group's blocks, which is padding where they don't fill it; groups of
+// consecutive ranks are boxes when their number divides processor[0].
+
+// seism-test.h5 -> seism-test.<file>.h5
+string piece_filename(const char* filename, int file)
+{
+    string name = filename;
+    size_t ext = name.rfind(".h5");
+    if (ext == string::npos) ext = name.size();
+    name.insert(ext, "." + to_string(file));
+    return name;
+}
+
+struct piece_files
+{
+    int             n_files;
+    vector<int>     file_of;        // the file of every rank
+    vector<hsize_t> start, size;    // the box of every file, 3 each
+    hsize_t         padding;        // elements per step not in any block
+};
+
+piece_files make_piece_files
+(
+    const seism_core_config&        cfg,
+    const seism_core_decomposition& decomposition,
+    MPI_Comm                        comm
+)
+{
+    int mpi_retval = 0;
+    int mpi_size, mpi_rank;
+    MPI_Comm_size(comm, &mpi_size);
+    MPI_Comm_rank(comm, &mpi_rank);
+
+    // -1 one file per process, -2 per node, else as many files
+    int file = mpi_rank;
+    if (cfg.file_groups == -2)
+    {
+        MPI_Comm node_comm;
+        mpi_retval = MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, mpi_rank,
+                MPI_INFO_NULL, &node_comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        mpi_retval = MPI_Bcast(&file, 1, MPI_INT, 0, node_comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        MPI_Comm_free(&node_comm);
+    }
+    else if (cfg.file_groups > 0)
+        file = (int) ((long) mpi_rank * cfg.file_groups / mpi_size);
+
+    // numbered in the order of their first rank
+    piece_files pieces;
+    pieces.file_of.resize(mpi_size);
+    mpi_retval = MPI_Allgather(&file, 1, MPI_INT, pieces.file_of.data(), 1, 
+            MPI_INT, comm);
+    assert(mpi_retval == MPI_SUCCESS);
+    vector<int> number(mpi_size, -1);
+    pieces.n_files = 0;
+    for (int r = 0; r < mpi_size; r++)
+    {
+        int& n = number[pieces.file_of[r]];
+        if (n < 0) n = pieces.n_files++;
+        pieces.file_of[r] = n;
+    }
+
+    vector<hsize_t> end(3 * pieces.n_files, 0);
+    pieces.start.assign(3 * pieces.n_files, ~(hsize_t) 0);
+    pieces.size.resize(3 * pieces.n_files);
+    hsize_t in_blocks = 0, in_boxes = 0;
+    for (int r = 0; r < mpi_size; r++)
+    {
+        hsize_t block_number[3], start[3], size[3];
+        block_of_rank(r, cfg.processor, block_number);
+        decomposition_block(decomposition, block_number, start, size);
+        for (int d = 0; d < 3; d++)
+        {
+            hsize_t* box_start = &pieces.start[3 * pieces.file_of[r] + d];
+            hsize_t* box_end = &end[3 * pieces.file_of[r] + d];
+            *box_start = min(*box_start, start[d]);
+            *box_end = max(*box_end, start[d] + size[d]);
+        }
+        in_blocks += size[0] * size[1] * size[2];
+    }
+    for (int f = 0; f < pieces.n_files; f++)
+    {
+        for (int d = 0; d < 3; d++)
+            pieces.size[3 * f + d] = end[3 * f + d] - pieces.start[3 * f + d];
+        in_boxes += pieces.size[3 * f] * pieces.size[3 * f + 1] * 
+            pieces.size[3 * f + 2];
+    }
+    pieces.padding = in_boxes - in_blocks;
+    return pieces;
+}
+
+// Process 0 creates the output file with a virtual dataset per variable over
+// the global domain, mapping the box of every piece file, or its blocks one 
+// by one where they don't fill it, and with the digests of all blocks. The
+// piece files are named relative to the output file, next to which HDF5 
+// looks for them. Returns the number of mappings of a dataset.
+size_t create_virtual_datasets
+(
+    const seism_core_config&        cfg,
+    const seism_core_decomposition& decomposition,
+    const piece_files&              pieces,
+    const vector<uint64_t>&         digests     // of every block, or none
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    assert(fapl >= 0);
+    herr_retval = H5Pset_libver_bounds(fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+    assert(herr_retval >= 0);
+    hid_t file = H5Fcreate(cfg.filename, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    assert(file >= 0);
+
+    int n_ranks = (int) pieces.file_of.size();
+    vector<hsize_t> block_numbers(3 * n_ranks);
+    vector<hsize_t> in_file(pieces.n_files, 0);
+    for (int r = 0; r < n_ranks; r++)
+    {
+        hsize_t start[3], size[3];
+        block_of_rank(r, cfg.processor, &block_numbers[3 * r]);
+        decomposition_block(decomposition, &block_numbers[3 * r], start, size);
+        in_file[pieces.file_of[r]] += size[0] * size[1] * size[2];
+    }
+
+    hsize_t dims[4] = {cfg.simulation_time, 
+        decomposition_extent(decomposition, 0), 
+        decomposition_extent(decomposition, 1), 
+        decomposition_extent(decomposition, 2)};
+    hid_t vspace = H5Screate_simple(4, dims, NULL);
+    assert(vspace >= 0);
+    hid_t element_type = element_hdf5_type(cfg.file_type, true);
+    hsize_t count[4] = {1, 1, 1, 1};
+    size_t n_mappings = 0;
+    for (int i = 0; i < cfg.variables; i++)
+    {
+        string name = variable_dset_name(i);
+        hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+        assert(dcpl >= 0);
+        n_mappings = 0;
+        for (int f = 0; f < pieces.n_files; f++)
+        {
+            string source = piece_filename(cfg.filename, f);
+            source = source.substr(source.rfind('/') + 1);
+            const hsize_t* box_start = &pieces.start[3 * f];
+            const hsize_t* box_size = &pieces.size[3 * f];
+            hsize_t source_dims[4] = {cfg.simulation_time, box_size[0], 
+                box_size[1], box_size[2]};
+            hid_t sspace = H5Screate_simple(4, source_dims, NULL);
+            assert(sspace >= 0);
+            bool filled = in_file[f] == box_size[0] * box_size[1] * box_size[2];
+            for (int r = 0; r < n_ranks; r++)
+            {
+                if (pieces.file_of[r] != f) continue;
+                hsize_t start[4] = {0, 0, 0, 0}, block[4];
+                copy(source_dims, source_dims + 4, block);
+                if (!filled)
+                    decomposition_block(decomposition, &block_numbers[3 * r], 
+                            start + 1, block + 1);
+                hsize_t source_start[4] = {0, 0, 0, 0};
+                for (int d = 0; d < 3; d++) 
+                {
+                    if (filled) start[d + 1] = box_start[d];
+                    source_start[d + 1] = start[d + 1] - box_start[d];
+                }
+                herr_retval = H5Sselect_hyperslab(vspace, H5S_SELECT_SET, 
+                        start, NULL, count, block);
+                assert(herr_retval >= 0);
+                herr_retval = H5Sselect_hyperslab(sspace, H5S_SELECT_SET, 
+                        source_start, NULL, count, block);
+                assert(herr_retval >= 0);
+                herr_retval = H5Pset_virtual(dcpl, vspace, source.c_str(), 
+                        name.c_str(), sspace);
+                assert(herr_retval >= 0);
+                n_mappings++;
+                if (filled) break;
+            }
+            H5Sclose(sspace);
+        }
+        herr_retval = H5Sselect_all(vspace);
+        assert(herr_retval >= 0);
+        hid_t dset = H5Dcreate(file, name.c_str(), element_type, vspace, 
+                H5P_DEFAULT, dcpl, H5P_DEFAULT);
+        assert(dset >= 0);
+        H5Dclose(dset);
+        H5Pclose(dcpl);
+    }
+    H5Tclose(element_type);
+    H5Sclose(vspace);
+
+    if (!digests.empty())
+        write_digests(file, cfg.simulation_time, cfg.processor, block_numbers,
+                digests, H5P_DEFAULT);
+
+    herr_retval = H5Fclose(file);
+    assert(herr_retval >= 0);
+    H5Pclose(fapl);
+    return n_mappings;
+}
+
+// Reading this rank's block of every timestep of the first variable, from
+// the start of H5Fopen() to the end of H5Fclose(), where HDF5 opens and 
+// closes the source files of a virtual dataset. Every rank opens the file on
+// its own: parallel HDF5 would open the source files collectively whenever a
+// read first touches them, which ranks reading different pieces never agree
+// on.
+double time_block_read
+(
+    const char*    filename,
+    const hsize_t* start,           // in the dataset of that file
+    const hsize_t* block,
+    unsigned int   simulation_time,
+    int            type
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    double begin = MPI_Wtime();
+
+    hid_t file = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+    assert(file >= 0);
+    hid_t dset = H5Dopen(file, CHUNKED_DSET_NAME, H5P_DEFAULT);
+    assert(dset >= 0);
+    hid_t fspace = H5Dget_space(dset);
+    assert(fspace >= 0);
+    hsize_t count[4] = {1, 1, 1, 1};
+    hsize_t step_start[4] = {0, start[0], start[1], start[2]};
+    hsize_t step_block[4] = {1, block[0], block[1], block[2]};
+    hid_t mspace = H5Screate_simple(4, step_block, NULL);
+    assert(mspace >= 0);
+    hid_t mem_type = element_hdf5_type(type, false);
+    vector<char> buffer(block[0] * block[1] * block[2] * element_size(type));
+    for (unsigned int t = 0; t < simulation_time; t++)
+    {
+        step_start[0] = t;
+        herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, step_start, 
+                NULL, count, step_block);
+        assert(herr_retval >= 0);
+        herr_retval = H5Dread(dset, mem_type, mspace, fspace, H5P_DEFAULT, 
+                &buffer[0]);
+        assert(herr_retval >= 0);
+    }
+    H5Tclose(mem_type);
+    H5Sclose(mspace);
+    H5Sclose(fspace);
+    H5Dclose(dset);
+    herr_retval = H5Fclose(file);
+    assert(herr_retval >= 0);
+
+    return MPI_Wtime() - begin;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Subfiling: with the subfiling VFD of HDF5 1.14+ (H5Pset_fapl_subfiling)
+// the file named is a small stub, and the data is striped in stripe size
+// pieces over subfiles next to it, which I/O concentrator threads on some 
+// of the ranks write. The library has it if it was built with it, which 
+// defines H5_HAVE_SUBFILING_VFD, and it needs MPI_THREAD_MULTIPLE. The 
+// subfiles are named after the inode of the stub, 
+// <file>.subfile_<inode>_<i>_of_<n>, next to <file>.subfile_<inode>.config.
+
+// subfiling_ioc: "node [n]", n concentrators per node (1 if not given), 
+// "nth <n>", one on every n-th rank, or "total <n>", n in all, and "" for
+// the library's choice; false if it is none of these
+bool parse_subfiling_ioc(const char* text, string& method, int& count)
+{
+    istringstream iss(text);
+    method = "";
+    count = 1;
+    if (!(iss >> method)) return true;
+    int n;
+    if (iss >> n) count = n;
+    else if (method != "node") return false;
+    return count > 0 && 
+        (method == "node" || method == "nth" || method == "total");
+}
+
+#ifdef H5_HAVE_SUBFILING_VFD
+// subfiling over comm with the stripe size and concentrators of cfg; false
+// if the library rejects it. The library only accepts one concentrator per
+// node in the configuration, and takes any other choice from the 
+// environment when the file is opened, so that is left there for 
+// H5Fcreate() to find until clear_subfiling_environment().
+bool set_fapl_subfiling
+(
+    hid_t                    fapl,
+    const seism_core_config& cfg,
+    MPI_Comm                 comm,
+    MPI_Info                 info
+)
+{
+    herr_t herr_retval = H5Pset_mpi_params(fapl, comm, info);
+    assert(herr_retval >= 0);
+
+    // the defaults, as the fapl isn't set to subfiling yet
+    H5FD_subfiling_config_t config;
+    if (H5Pget_fapl_subfiling(fapl, &config) < 0) return false;
+    if (cfg.subfiling_stripe_size) 
+        config.shared_cfg.stripe_size = (int64_t) cfg.subfiling_stripe_size;
+
+    string method;
+    int count;
+    parse_subfiling_ioc(cfg.subfiling_ioc, method, count);
+    ostringstream value;
+    if (method == "node")
+    {
+        value << count;
+        setenv(H5FD_SUBFILING_IOC_PER_NODE, value.str().c_str(), 1);
+    }
+    else if (!method.empty())
+    {
+        // "<H5FD_subfiling_ioc_select_t>:<count>"
+        value << (int) (method == "nth" ? SELECT_IOC_EVERY_NTH_RANK : 
+                SELECT_IOC_TOTAL) << ":" << count;
+        setenv(H5FD_SUBFILING_IOC_SELECTION_CRITERIA, value.str().c_str(), 1);
+    }
+
+    bool set = H5Pset_fapl_subfiling(fapl, &config) >= 0;
+    H5Pclose(config.ioc_fapl_id);
+    return set;
+}
+
+// so that the next case, or a reader in this process, chooses again
+void clear_subfiling_environment(const seism_core_config& cfg)
+{
+    if (!cfg.subfiling_ioc[0]) return;
+    unsetenv(H5FD_SUBFILING_IOC_PER_NODE);
+    unsetenv(H5FD_SUBFILING_IOC_SELECTION_CRITERIA);
+}
+#endif
+
+// the subfiles and configuration file of a subfiled file
+void remove_subfiles(const char* filename)
+{
+    struct stat file_stat;
+    if (stat(filename, &file_stat)) return;
+    ostringstream pattern;
+    pattern << filename << ".subfile_" << (unsigned long long) file_stat.st_ino 
+            << "*";
+    glob_t found;
+    if (glob(pattern.str().c_str(), 0, NULL, &found)) return;
+    for (size_t i = 0; i < found.gl_pathc; i++) remove(found.gl_pathv[i]);
+    globfree(&found);
+}
+
+// the output file, and its piece files or subfiles if it has them
+void remove_output(const char* filename, int piece_files)
+{
+    remove_subfiles(filename);
+    remove(filename);
+    for (int f = 0; f < piece_files; f++) 
+        remove(piece_filename(filename, f).c_str());
+}
+
+// the simulation attributes of the file
+void write_simulation_attributes
+(
+    hid_t                           file,
+    seism_core_config&              cfg,
+    hsize_t*                        domain,     // the nominal block
+    bool                            evict_on_close_set,
+    double                          type_scale,
+    const seism_core_decomposition& decomposition,
+    int                             piece_files
+)
+{
+    seismCoreAttributes attr((char*)"my_attr", cfg.processor, cfg.chunk, domain, 
+            cfg.simulation_time, cfg.n_nodes, cfg.subfile, cfg.collective_write, cfg.precreate, 
+            cfg.set_collective_metadata, cfg.never_fill, cfg.deflate, cfg.zfp,
+            cfg.use_function_lib, cfg.use_function_name, cfg.use_function_argc, 
+            cfg.use_function_argv );
+    copy(cfg.mdc_size, cfg.mdc_size + 3, attr.mdc_size);
+    attr.mdc_no_evictions = cfg.mdc_no_evictions;
+    attr.file_space_strategy = cfg.file_space_strategy;
+    attr.file_space_persist = cfg.file_space_persist;
+    attr.file_space_page_size = cfg.file_space_page_size;
+    attr.page_buffer_size = cfg.page_buffer_size;
+    attr.meta_block_size = cfg.meta_block_size;
+    attr.coll_metadata_write = cfg.coll_metadata_write;
+    attr.evict_on_close = cfg.evict_on_close && evict_on_close_set;
+    attr.filters = cfg.filters;
+    attr.element_type = (char*) element_type_name(cfg.file_type);
+    attr.memory_type = (char*) element_type_name(cfg.memory_type);
+    attr.type_scale = type_scale;
+    attr.own_conversion = cfg.own_conversion;
+    string decomposition_lists = decomposition_string(decomposition);
+    attr.decomposition = (char*) decomposition_lists.c_str();
+    attr.piece_files = piece_files;
+    attr.subfiling = cfg.subfiling;
+    attr.subfiling_stripe_size = cfg.subfiling_stripe_size;
+    attr.subfiling_ioc = cfg.subfiling_ioc;
+    attr.writeAttributesToFile(file);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Combinations parallel HDF5 refuses to write, found from the configuration 
+// alone so that a sweep can skip them and run the rest: filtered datasets 
+// are only written collectively, and deflated direct chunks by a single 
+// writer per file. The writers of a file per node aren't known before the 
+// run, and run_case() checks those itself.
+
+string case_problem(const seism_core_config& cfg)
+{
+    int processor_count = cfg.processor[0] * cfg.processor[1] * cfg.processor[2];
+    int writers = cfg.io_servers ? cfg.io_servers : processor_count;
+    if (cfg.file_groups == -1) writers = 1;
+    else if (cfg.file_groups > 0) 
+        writers = (processor_count + cfg.file_groups - 1) / cfg.file_groups;
+    else if (cfg.file_groups == -2 || cfg.node_aggregate) writers = 1;
+    if (writers <= 1 || cfg.subfile) return "";
+
+    bool pipeline = cfg.zfp || cfg.filters[0] || (cfg.deflate && !cfg.direct_chunk);
+    if (pipeline && !cfg.collective_write)
+        return "filtered datasets need collective_write with more than one "
+            "writer per file";
+    if (cfg.direct_chunk && cfg.deflate && !cfg.zfp && !cfg.filters[0])
+        return "direct_chunk with deflate needs one process per file";
+    return "";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Create the file, write every timestep and report, for one configuration.
+
+void run_case
+(
+    seism_core_config& cfg,
+    MPI_Comm           comm,                // the ranks that run the case
+    int                mpi_thread_provided,
+    seism_core_result& result
+)
+{
+    herr_t herr_retval = (herr_t) 0;
+    int mpi_retval = 0;
+    int mpi_size, mpi_rank;
+
+    MPI_Comm_size(comm, &mpi_size);
+    MPI_Comm_rank(comm, &mpi_rank);
+    double begin = MPI_Wtime();
+
+    // check the arguments
+    //FTW was:  assert(time > 0);
+    assert(cfg.simulation_time > 0);
+
+    //assert(processor[0]*processor[1]*processor[2] == (hsize_t) mpi_size);
+    // FTW: Some things just shouldn't be assertions...
+    //assert(processor_count == mpi_size);
+    int processor_count = cfg.processor[0] * cfg.processor[1] * cfg.processor[2];
+    if (processor_count + cfg.io_servers != mpi_size)
+    {
+        if (mpi_rank==0) printf("processor count of %d plus %d I/O servers doesn't match mpi_size of %d\nExiting.\n", 
+                processor_count, cfg.io_servers, mpi_size);
+        exit(126);
+    } 
+
+    // the decomposition of the global domain; from here on cfg.domain is
+    // this rank's own block, I/O servers keep the nominal one, which is
+    // restored for the report
+    hsize_t nominal_domain[3];
+    copy(cfg.domain, cfg.domain + 3, nominal_domain);
+    seism_core_decomposition decomposition = make_decomposition(cfg, mpi_rank);
+    bool irregular = !is_regular(decomposition);
+    // equal split lists are a regular decomposition with another domain
+    if (!irregular)
+        for (int d = 0; d < 3; d++) nominal_domain[d] = decomposition.sizes[d][0];
+    if (irregular && (cfg.io_servers || cfg.node_aggregate || cfg.direct_chunk ||
+                cfg.memory_budget))
+    {
+        if (mpi_rank==0) printf("split and imbalance can't be combined with "
+                "io_servers, node_aggregate, direct_chunk or memory_budget"
+                "\nExiting.\n");
+        exit(126);
+    }
+    if (mpi_rank < processor_count)
+    {
+        hsize_t number[3] = {mpi_rank / (cfg.processor[1] * cfg.processor[2]),
+            (mpi_rank / cfg.processor[2]) % cfg.processor[1], 
+            mpi_rank % cfg.processor[2]};
+        for (int d = 0; d < 3; d++) 
+            cfg.domain[d] = decomposition.sizes[d][number[d]];
+    }
+    if (cfg.io_servers && ((hsize_t) cfg.io_servers > cfg.processor[0] || cfg.subfile))
+    {
+        if (mpi_rank==0) printf("io_servers must be at most processor[0] = %d, without subfile\nExiting.\n", 
+                (int) cfg.processor[0]);
+        exit(126);
+    }
+
+    if (cfg.io_servers && cfg.node_aggregate)
+    {
+        if (mpi_rank==0) printf("io_servers and node_aggregate can't be combined\nExiting.\n");
+        exit(126);
+    }
+    if (cfg.variables < 1) cfg.variables = 1;
+    if (cfg.extend_time && cfg.subfile)
+    {
+        if (mpi_rank==0) printf("extend_time needs chunking, which subfile doesn't use\nExiting.\n");
+        exit(126);
+    }
+    // the virtual datasets map fixed extents of every piece file
+    if (cfg.file_groups && (cfg.file_groups < -2 || cfg.file_groups > processor_count
+                || cfg.io_servers || cfg.node_aggregate || cfg.subfile || 
+                cfg.extend_time))
+    {
+        if (mpi_rank==0) printf("file_groups is process, node or a number of "
+                "files up to the number of processes, and can't be combined "
+                "with io_servers, node_aggregate, subfile or extend_time"
+                "\nExiting.\n");
+        exit(126);
+    }
+    // the stub of a subfiled file can't be created serially and reopened, 
+    // and its subfiles take the place of the piece files
+    string ioc_method;
+    int ioc_count;
+    if (cfg.subfiling && (cfg.subfile || cfg.file_groups || cfg.precreate || 
+                !parse_subfiling_ioc(cfg.subfiling_ioc, ioc_method, ioc_count)))
+    {
+        if (mpi_rank==0) printf("subfiling can't be combined with subfile, "
+                "file_groups or precreate, and subfiling_ioc is node [n], "
+                "nth <n> or total <n>\nExiting.\n");
+        exit(126);
+    }
+#ifdef H5_HAVE_SUBFILING_VFD
+    if (cfg.subfiling && mpi_thread_provided < MPI_THREAD_MULTIPLE)
+    {
+        if (mpi_rank==0) printf("subfiling requires MPI_THREAD_MULTIPLE, "
+                "which the MPI library doesn't provide\nExiting.\n");
+        exit(126);
+    }
+#else
+    if (cfg.subfiling)
+    {
+        if (mpi_rank==0) printf("subfiling requires HDF5 1.14+ built with the "
+                "subfiling VFD\nExiting.\n");
+        exit(126);
+    }
+#endif
+    if (cfg.variables > 1 && (cfg.io_servers || cfg.node_aggregate))
+    {
+        if (mpi_rank==0) printf("variables can't be combined with io_servers or node_aggregate\nExiting.\n");
+        exit(126);
+    }
+    vector<string> stages = filter_stages(cfg.deflate, cfg.zfp, cfg.filters);
+    bool use_zfp = false, lossy = false;
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        use_zfp = use_zfp || !stages[i].compare(0, 3, "zfp");
+        lossy = lossy || is_lossy_filter(stages[i]);
+    }
+    // the threads only deflate; other filters go through the pipeline
+    bool direct_fallback = false;
+    if (cfg.direct_chunk && (cfg.zfp || cfg.filters[0]))
+    {
+        if (mpi_rank==0) printf("direct_chunk only compresses with deflate, "
+                "using the filter pipeline instead.\n");
+        cfg.direct_chunk = 0;
+        direct_fallback = true;
+    }
+    // element types: the block is made in float, scaled, held in memory in
+    // memory_type and stored as file_type
+    if (cfg.file_type < 0 || cfg.memory_type < 0)
+    {
+        if (mpi_rank==0) printf("file_type and memory_type are one of f32, f64, "
+                "f16, i16 and i32\nExiting.\n");
+        exit(126);
+    }
+    double type_scale = cfg.type_scale ? cfg.type_scale : 1.0;
+    bool convert_types = (cfg.file_type != cfg.memory_type);
+    bool typed = cfg.file_type != ELEMENT_F32 || cfg.memory_type != ELEMENT_F32 
+        || type_scale != 1.0;
+    if (typed && (cfg.io_servers || cfg.node_aggregate || cfg.direct_chunk))
+    {
+        if (mpi_rank==0) printf("file_type, memory_type and type_scale can't be "
+                "combined with io_servers, node_aggregate or direct_chunk\nExiting.\n");
+        exit(126);
+    }
+    if (cfg.memory_type != ELEMENT_F32 && (cfg.compute_time > 0.0 || cfg.async_write))
+    {
+        if (mpi_rank==0) printf("memory_type other than f32 can't be combined "
+                "with compute_time or async_write\nExiting.\n");
+        exit(126);
+    }
+    // nbit and scaleoffset are set up for float, ZFP takes float or double
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        bool float_only = !stages[i].compare(0, 4, "nbit") || 
+            !stages[i].compare(0, 11, "scaleoffset");
+        if ((float_only && cfg.file_type != ELEMENT_F32) || (use_zfp && 
+                    cfg.file_type != ELEMENT_F32 && cfg.file_type != ELEMENT_F64))
+        {
+            if (mpi_rank==0) printf("nbit and scaleoffset need file_type f32, "
+                    "zfp f32 or f64\nExiting.\n");
+            exit(126);
+        }
+    }
+    // the digests are of the float block, which only f32 and f64 files hold
+    if (cfg.digest && (cfg.memory_type != ELEMENT_F32 || type_scale != 1.0 ||
+                (cfg.file_type != ELEMENT_F32 && cfg.file_type != ELEMENT_F64)))
+    {
+        if (mpi_rank==0) printf("digest needs the float values unchanged: "
+                "memory_type f32, file_type f32 or f64 and no type_scale; "
+                "not computing digests.\n");
+        cfg.digest = 0;
+    }
+    if (!convert_types) cfg.own_conversion = 0;
+
+    // halo: the block is the interior of a padded float array, written from
+    // there as a whole
+    if (cfg.halo < 0 || (cfg.halo && (cfg.io_servers || cfg.node_aggregate || 
+                cfg.direct_chunk || cfg.memory_budget || cfg.compute_time > 0.0 ||
+                cfg.async_write || cfg.memory_type != ELEMENT_F32)))
+    {
+        if (mpi_rank==0) printf("halo can't be negative or combined with "
+                "io_servers, node_aggregate, direct_chunk, memory_budget, "
+                "compute_time, async_write or a memory_type other than f32"
+                "\nExiting.\n");
+        exit(126);
+    }
+    if (!cfg.halo) cfg.halo_pack = 0;
+    if (cfg.halo && !cfg.halo_pack && cfg.own_conversion)
+    {
+        if (mpi_rank==0) printf("own_conversion needs a contiguous block, "
+                "with halo only with halo_pack\nExiting.\n");
+        exit(126);
+    }
+
+    if (cfg.memory_budget && (cfg.io_servers || cfg.node_aggregate || 
+                cfg.direct_chunk || cfg.compute_time > 0.0 || cfg.async_write))
+    {
+        if (mpi_rank==0) printf("memory_budget can't be combined with io_servers, "
+                "node_aggregate, direct_chunk, compute_time or async_write\nExiting.\n");
+        exit(126);
+    }
+
+    // streaming: the rows of the block per slab within the memory budget,
+    // whole chunks along the first dimension when the budget allows
+    hsize_t slab_rows = cfg.domain[0];
+    if (cfg.memory_budget)
+    {
+        // the float slab, and its copies in the memory and file types
+        size_t element_bytes = sizeof(float) + (cfg.memory_type != ELEMENT_F32 ?
+            element_size(cfg.memory_type) : 0) + (cfg.own_conversion ? 
+            element_size(cfg.file_type) : 0);
+        hsize_t row_bytes = cfg.domain[1] * cfg.domain[2] * element_bytes;
+        slab_rows = max((hsize_t) 1, min(cfg.domain[0], cfg.memory_budget / row_bytes));
+        if (!cfg.subfile && slab_rows >= cfg.chunk[0] && slab_rows < cfg.domain[0])
+            slab_rows -= slab_rows % cfg.chunk[0];
+    }
+    hsize_t n_slabs = (cfg.domain[0] + slab_rows - 1) / slab_rows;
+
+    if (cfg.filters[0] && cfg.subfile)
+    {
+        if (mpi_rank==0) printf("filter needs chunking, which subfile doesn't use\nExiting.\n");
+        exit(126);
+    }
+    if (cfg.direct_chunk && (cfg.subfile || cfg.io_servers || cfg.node_aggregate))
+    {
+        if (mpi_rank==0) printf("direct_chunk can't be combined with subfile, "
+                "io_servers or node_aggregate\nExiting.\n");
+        exit(126);
+    }
+    if (cfg.direct_chunk && (cfg.domain[0] % cfg.chunk[0] || 
+                cfg.domain[1] % cfg.chunk[1] || cfg.domain[2] % cfg.chunk[2]))
+    {
+        if (mpi_rank==0) printf("direct_chunk requires chunk dimensions that "
+                "divide the per process grid\nExiting.\n");
+        exit(126);
+    }
+    // HDF5 only buffers the pages of files with paged allocation
+    const char* strategy = cfg.file_space_strategy;
+    if ((strategy[0] && strcmp(strategy, "fsm_aggr") && strcmp(strategy, "page") &&
+                strcmp(strategy, "aggr") && strcmp(strategy, "none")) ||
+            (cfg.page_buffer_size && strcmp(strategy, "page")))
+    {
+        if (mpi_rank==0) printf("file_space_strategy is fsm_aggr, page, aggr "
+                "or none, and page_buffer_size requires page\nExiting.\n");
+        exit(126);
+    }
+    if (cfg.page_buffer_size && !cfg.precreate)
+    {
+        if (mpi_rank==0) printf("page_buffer_size only applies with precreate, "
+                "as MPI-IO refuses page buffering; ignored.\n");
+        cfg.page_buffer_size = 0;
+    }
+#if ! H5_VERSION_GE(1,14,0)
+    if (cfg.multi_dataset)
+    {
+        if (mpi_rank==0) printf("multi_dataset requires HDF5 1.14+, "
+                "writing the datasets one by one.\n");
+        cfg.multi_dataset = 0;
+    }
+#endif
+
+    // with I/O servers, the compute ranks keep their place in the process 
+    // grid and only the servers, the ranks after them, open the file; with
+    // node aggregation, only the first rank of every node does
+    bool is_server = mpi_rank >= processor_count;
+    bool writes_file = !cfg.io_servers || is_server;
+    MPI_Comm file_comm = comm;
+    MPI_Comm node_comm = MPI_COMM_NULL;
+    int node_rank = 0, n_leaders = 0;
+    if (cfg.node_aggregate)
+    {
+        mpi_retval = MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 
+                mpi_rank, MPI_INFO_NULL, &node_comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        MPI_Comm_rank(node_comm, &node_rank);
+        writes_file = (node_rank == 0);
+        int is_leader = writes_file;
+        MPI_Allreduce(&is_leader, &n_leaders, 1, MPI_INT, MPI_SUM, comm);
+    }
+    if (cfg.io_servers || cfg.node_aggregate)
+    {
+        mpi_retval = MPI_Comm_split(comm, writes_file, mpi_rank, &file_comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        cfg.async_write = 0; // forwarding or aggregation is the overlap
+    }
+
+    // with piece files, every group of ranks opens a file of its own
+    piece_files pieces;
+    pieces.n_files = 0;
+    pieces.padding = 0;
+    int file_number = 0, file_rank = 0;
+    if (cfg.file_groups)
+    {
+        pieces = make_piece_files(cfg, decomposition, comm);
+        file_number = pieces.file_of[mpi_rank];
+        mpi_retval = MPI_Comm_split(comm, file_number, mpi_rank, &file_comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        MPI_Comm_rank(file_comm, &file_rank);
+    }
+    string file_name = cfg.file_groups ? 
+        piece_filename(cfg.filename, file_number) : cfg.filename;
+    // deflated chunks change size, and parallel HDF5 can't reallocate them
+    // from one rank alone: every file needs a single writer
+    if (cfg.direct_chunk && cfg.deflate)
+    {
+        vector<int> writers(cfg.file_groups ? pieces.n_files : 1, 0);
+        for (int r = 0; r < mpi_size; r++)
+            writers[cfg.file_groups ? pieces.file_of[r] : 0]++;
+        if (*max_element(writers.begin(), writers.end()) > 1)
+        {
+            if (mpi_rank==0) printf("direct_chunk with deflate needs one "
+                    "process per file, a single process or file_groups "
+                    "process\nExiting.\n");
+            exit(126);
+        }
+    }
+
+    // I'm removing the below restriction to allow for serial case
+    // assert(processor[0] > 1 && processor[1] > 1 && processor[2] > 1);
+
+    // decide how writes are overlapped with compute: HDF5 event sets when the
+    // async VOL connector is loaded, otherwise a background I/O thread
+    bool use_event_set = false;
+    if (cfg.async_write)
+    {
+#if H5_VERSION_GE(1,13,0)
+        const char* vol_connector = getenv("HDF5_VOL_CONNECTOR");
+        if (vol_connector && strstr(vol_connector, "async") && !cfg.direct_chunk &&
+                !cfg.own_conversion) 
+            use_event_set = true;
+#endif
+        // the async connector's background threads call MPI on their own
+        if (use_event_set && mpi_thread_provided < MPI_THREAD_MULTIPLE)
+        {
+            if (mpi_rank==0) printf("async_write with the async VOL connector "
+                    "requires MPI_THREAD_MULTIPLE\nExiting.\n");
+            exit(126);
+        }
+        if (!use_event_set && mpi_thread_provided < MPI_THREAD_SERIALIZED)
+        {
+            if (mpi_rank==0) printf("async_write requires MPI_THREAD_SERIALIZED, "
+                    "writes will not be overlapped.\n");
+            cfg.async_write = 0;
+        }
+    }
+
+    // Subfiling and chunking not compatible, so ignore chunk info
+    if (!cfg.subfile) assert(cfg.chunk[0] > 1 && cfg.chunk[1] > 1 && cfg.chunk[2] > 1);
+    assert(cfg.domain[0] > 0 && cfg.domain[1] > 0 && cfg.domain[2] > 0);
+
+    if (mpi_rank == 0)
+    {
+        cout << 
+        "====================================================================="
+        << endl;
+        cout << "Number of processes:\t\t" << mpi_size << endl;
+        cout << "Process layout:\t\t\t" << cfg.processor[0] << " x " <<
+            cfg.processor[1] << " x " << cfg.processor[2] << endl;
+        cout << "Per process grid:\t\t" << nominal_domain[0] << " x " 
+             << nominal_domain[1] << " x " << nominal_domain[2] << endl;
+        if (irregular)
+        {
+            // the range of the block sizes along each axis
+            cout << "Decomposition:\t\t\tirregular, ";
+            for (int d = 0; d < 3; d++)
+                cout << (d ? " x " : "") 
+                     << *min_element(decomposition.sizes[d].begin(), 
+                             decomposition.sizes[d].end()) << ".."
+                     << *max_element(decomposition.sizes[d].begin(), 
+                             decomposition.sizes[d].end());
+            cout << ", global " << decomposition_extent(decomposition, 0) << " x "
+                 << decomposition_extent(decomposition, 1) << " x " 
+                 << decomposition_extent(decomposition, 2) << endl;
+        }
+        if (!cfg.subfile) cout << "Chunk dimensions:\t\t" << cfg.chunk[0] << " x " 
+            << cfg.chunk[1] << " x " << cfg.chunk[2] << endl;
+        if (cfg.n_nodes) cout << "n_nodes:\t\t\t" << cfg.n_nodes << endl;
+        cout << "Number of time steps:\t\t" << cfg.simulation_time << endl;
+        cout << "Variables:\t\t\t" << cfg.variables;
+        if (cfg.variables > 1) 
+            cout << (cfg.multi_dataset ? " (H5Dwrite_multi)" : " (H5Dwrite each)");
+        cout << endl;
+        cout << "Pre-create:\t\t\t" << cfg.precreate << endl;
+        cout << "Extend time dimension:\t\t" << cfg.extend_time << endl;
+        cout << "Collective I/O:\t\t\t" << cfg.collective_write << endl;
+        cout << "Collective metadata requested:\t" << cfg.set_collective_metadata 
+             << endl;
+        cout << "H5D_FILL_TIME_NEVER set:\t" << cfg.never_fill << endl;
+        cout << "Collective metadata write:\t" << cfg.coll_metadata_write << endl;
+        if (cfg.mdc_size[0]) cout << "Metadata cache size:\t\t" << cfg.mdc_size[0] 
+            << " (" << cfg.mdc_size[1] << " - " << cfg.mdc_size[2] << ")" << endl;
+        cout << "Metadata cache evictions:\t" << !cfg.mdc_no_evictions << endl;
+        cout << "File space strategy:\t\t" 
+             << (cfg.file_space_strategy[0] ? cfg.file_space_strategy : "default");
+        if (cfg.file_space_persist) cout << " (persistent)";
+        cout << endl;
+        cout << "File space page size:\t\t" << cfg.file_space_page_size << endl;
+        cout << "Page buffer size:\t\t" << cfg.page_buffer_size << endl;
+        cout << "Metadata block size:\t\t" << cfg.meta_block_size << endl;
+        cout << "Evict on close:\t\t\t" << cfg.evict_on_close << endl;
+        cout << "Deflate: \t\t\t" << cfg.deflate << endl;
+        cout << "Direct chunk writes:\t\t" << cfg.direct_chunk;
+        if (cfg.direct_chunk) cout << " thread(s)";
+        if (direct_fallback) cout << " (filter pipeline: only deflate is "
+            "compressed directly)";
+        cout << endl;
+        cout << "Subfile: \t\t\t" << cfg.subfile << endl;
+        cout << "Subfiling VFD:\t\t\t" << cfg.subfiling;
+        if (cfg.subfiling)
+        {
+            cout << " (stripe size ";
+            if (cfg.subfiling_stripe_size) cout << cfg.subfiling_stripe_size;
+            else cout << "default";
+            cout << ", I/O concentrators ";
+            if (ioc_method.empty()) cout << "default";
+            else if (ioc_method == "node") cout << ioc_count << " per node";
+            else if (ioc_method == "nth") cout << "on every " << ioc_count 
+                                               << "th rank";
+            else cout << ioc_count << " in all";
+            cout << ")";
+        }
+        cout << endl;
+        cout << "ZFP: \t\t\t\t" << cfg.zfp << endl;
+        cout << "Filters: \t\t\t";
+        for (size_t i = 0; i < stages.size(); i++)
+            cout << (i ? " | " : "") << stages[i];
+        if (stages.empty()) cout << "none";
+        if (lossy) cout << " (lossy)";
+        cout << endl;
+        cout << "Element types: \t\t\t" << element_type_name(cfg.memory_type) 
+             << " in memory, " << element_type_name(cfg.file_type) << " in the file";
+        if (type_scale != 1.0) cout << ", scaled by " << type_scale;
+        if (convert_types) 
+            cout << (cfg.own_conversion ? " (converted by seism-core)" : 
+                    " (converted by HDF5)");
+        cout << endl;
+        cout << "Halo: \t\t\t\t" << cfg.halo;
+        if (cfg.halo)
+            cout << " (padded block " << cfg.domain[0] + 2 * cfg.halo << " x " 
+                 << cfg.domain[1] + 2 * cfg.halo << " x " 
+                 << cfg.domain[2] + 2 * cfg.halo << ", interior " 
+                 << (cfg.halo_pack ? "packed" : "selected in memory") << ")";
+        cout << endl;
+        cout << "Compute phase: \t\t\t" << cfg.compute_time << " s" << endl;
+        cout << "Memory budget: \t\t\t" << cfg.memory_budget;
+        if (cfg.memory_budget) cout << " (" << n_slabs << " slabs of " << slab_rows 
+            << " rows)";
+        cout << endl;
+        cout << "Async write: \t\t\t" << cfg.async_write;
+        if (cfg.async_write) cout << (use_event_set ? " (event set)" : " (I/O thread)");
+        cout << endl;
+        cout << "stripe size: \t\t\t" << cfg.lfs_stripe_size << endl;
+        cout << "stripe count: \t\t\t" << cfg.lfs_stripe_count << endl;
+        cout << "Alignment: \t\t\t";
+        if (cfg.align[0] || cfg.lfs_stripe_size) 
+            cout << (cfg.align[0] ? cfg.align[0] : cfg.lfs_stripe_size);
+        else cout << 0;
+        cout << endl;
+        cout << "Block digests: \t\t\t" << cfg.digest << endl;
+        cout << "I/O servers: \t\t\t" << cfg.io_servers << endl;
+        cout << "Node aggregation: \t\t" << cfg.node_aggregate;
+        if (cfg.node_aggregate) cout << " (" << n_leaders << " node leaders)";
+        cout << endl;
+        cout << "File groups: \t\t\t";
+        if (cfg.file_groups)
+        {
+            cout << pieces.n_files << " piece files (";
+            if (cfg.file_groups == -1) cout << "one per process";
+            else if (cfg.file_groups == -2) cout << "one per node";
+            else cout << "groups of " << processor_count / pieces.n_files 
+                      << (processor_count % pieces.n_files ? "+" : "") << " ranks";
+            cout << "), " << piece_filename(cfg.filename, 0) << " ...";
+            if (pieces.padding) 
+                cout << ", padded by " << pieces.padding << " elements per step";
+        }
+        else cout << "0 (one shared file)";
+        cout << endl;
+        cout << "Output filename: \t\t" << cfg.filename << endl;
+        cout << "Timing file: \t\t\t" << cfg.timing_file << ".{json,csv}" << endl;
+        if (cfg.results_file[0])
+            cout << "Results file: \t\t\t" << cfg.results_file << endl;
+        if (cfg.compare_results[0])
+            cout << "Baseline: \t\t\t" << cfg.compare_results << " (alpha " 
+                 << cfg.compare_alpha << ", at least " << cfg.compare_threshold 
+                 << " % slower)" << endl;
+        cout << endl;
+
+        // attempt to set striping, if requested; files created through MPI-IO
+        // get it from the striping hints instead, only a precreated file, 
+        // created by process 0 alone, needs lfs
+        if ((cfg.lfs_stripe_size || cfg.lfs_stripe_count) && cfg.precreate) {
+            cout << "Finding lfs command:" << endl;
+            int lfs_status = system("which lfs");
+            if (lfs_status) {
+                cout << endl 
+                     << "Lustre lfs utility not found. " 
+                     << "File will have default striping, if any." << endl 
+                     << endl;
+            }
+            else {
+                char lfs_size_str[256];
+                lfs_size_str[0] = (char)0;
+                char lfs_count_str[256];
+                lfs_count_str[0] = (char)0;
+                if (cfg.lfs_stripe_size) sprintf(lfs_size_str, "-s %d ", cfg.lfs_stripe_size);
+                if (cfg.lfs_stripe_count) sprintf(lfs_count_str, "-c %d ", cfg.lfs_stripe_count);
+                char lfs_command[256];
+                cout << "Setting striping info:" << endl;
+                // sprintf(lfs_command, "lfs setstripe %s %s %s > /dev/null ", lfs_size_str, lfs_count_str, cfg.filename);
+                sprintf(lfs_command, "lfs setstripe %s %s %s ", lfs_size_str, lfs_count_str, cfg.filename);
+                cout << lfs_command << endl << endl;
+                // assert(system(lfs_command) == 0) ; // run striping command on shell.
+                int retval = system(lfs_command); // run striping command on shell.
+                if (retval != 0) 
+                {
+                    printf(">>>%s<<<\nCommand failed.\n", lfs_command);
+                    exit(retval);
+                }
+            }
+        }
+    }
+
+    MPI_Barrier(comm);
+
+    //////////////////////////////////////////////////////////////////////////
+    // create the fle dataspace, time dimension first!
+    hsize_t n_dims = 4;
+    hsize_t dims[H5S_MAX_RANK];
+
+    dims[0] = cfg.simulation_time;
+    dims[1] = decomposition_extent(decomposition, 0);
+    dims[2] = decomposition_extent(decomposition, 1);
+    dims[3] = decomposition_extent(decomposition, 2);
+    // a piece file holds the box of its group
+    if (cfg.file_groups)
+        copy(&pieces.size[3 * file_number], &pieces.size[3 * file_number] + 3,
+                dims + 1);
+
+    // with extend_time, the datasets start out empty and grow by a timestep
+    // before each is written
+    hsize_t maxdims[H5S_MAX_RANK];
+    copy(dims, dims + n_dims, maxdims);
+    if (cfg.extend_time)
+    {
+        dims[0] = 0;
+        maxdims[0] = H5S_UNLIMITED;
+    }
+
+    hid_t fspace = H5Screate_simple(n_dims, dims, maxdims);
+    assert(fspace >= 0);
+
+    // set up chunking... NOTE: extent of time dimension is 1
+
+    hsize_t cdims[H5S_MAX_RANK];
+    cdims[0] = 1;
+    cdims[1] = cfg.chunk[0];
+    cdims[2] = cfg.chunk[1];
+    cdims[3] = cfg.chunk[2];
+    if (cfg.file_groups)
+        for (int d = 1; d < 4; d++) cdims[d] = min(cdims[d], dims[d]);
+
+    // create dcpl and set properties
+    hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    assert(dcpl >= 0);
+    // subfiling not compatible with chunking
+    if (!cfg.subfile)
+    {  
+         herr_retval = H5Pset_chunk(dcpl, n_dims, cdims);
+         assert(herr_retval >= 0);
+    }
+    if (cfg.never_fill)
+    {
+         herr_retval = H5Pset_fill_time(dcpl, H5D_FILL_TIME_NEVER );
+         assert(herr_retval >= 0);
+    }
+    herr_retval = H5Pset_alloc_time(dcpl, H5D_ALLOC_TIME_EARLY);
+    assert(herr_retval >= 0);
+
+    // the filter chain, deflate and ZFP included
+#ifdef INCLUDE_ZFP
+    if (use_zfp) 
+    {
+         herr_retval = H5Z_zfp_initialize();
+         assert(herr_retval >= 0);
+    }
+#endif
+    hid_t element_file_type = element_hdf5_type(cfg.file_type, true);
+    hid_t file_type = element_file_type;
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        if (!set_filter(stages[i], dcpl, file_type))
+        {
+            if (mpi_rank==0) printf("unknown or unavailable filter: %s\nExiting.\n",
+                    stages[i].c_str());
+            exit(126);
+        }
+    }
+
+    hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
+    assert(dapl >= 0);
+    ///////////////////////////////////////////////////////////////////////////
+    // prepare hyperslab selection
+    hsize_t start[4], block[4], count[4] = {1,1,1,1};
+
+    // calculate offsets from MPI rank
+    start[3] = (hsize_t) mpi_rank % cfg.processor[2];
+    start[2] = (hsize_t) ((mpi_rank - start[3])/cfg.processor[2]) % cfg.processor[1];
+    start[1] = (hsize_t) ((mpi_rank - start[3])/cfg.processor[2] - start[2]) /
+      cfg.processor[1];
+    hsize_t domain_block_number[3];
+    domain_block_number[0] = start[1];
+    domain_block_number[1] = start[2];
+    domain_block_number[2] = start[3];
+    // where the block starts; I/O servers are beyond the process grid
+    for (int d = 0; d < 3; d++)
+        start[d + 1] = start[d + 1] < cfg.processor[d] ? 
+            decomposition.offsets[d][start[d + 1]] : start[d + 1] * cfg.domain[d];
+    if (cfg.file_groups)
+        for (int d = 0; d < 3; d++) start[d + 1] -= pieces.start[3 * file_number + d];
+
+    block[0] = 1;
+    block[1] = cfg.domain[0];
+    block[2] = cfg.domain[1];
+    block[3] = cfg.domain[2];
+
+    ///////////////////////////////////////////////////////////////////////////
+    // data transfer property list for collective I/O, if selected
+    hid_t dxpl = H5P_DEFAULT;
+    if (cfg.collective_write)
+    {
+        dxpl = H5Pcreate(H5P_DATASET_XFER);
+        herr_retval = H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+        assert (herr_retval > 0);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // create in-memory dataspace
+    dims[0] = 1;
+    dims[1] = cfg.domain[0];
+    dims[2] = cfg.domain[1];
+    dims[3] = cfg.domain[2];
+
+    hid_t mspace = H5Screate_simple(n_dims, dims, NULL);
+    assert(mspace >= 0);
+    herr_retval = H5Sselect_all(mspace);
+    assert(herr_retval >= 0);
+
+    // chunks of the block for direct chunk writes
+    chunk_writer direct;
+    for (int d = 0; d < 3; d++)
+    {
+        direct.block[d] = cfg.domain[d];
+        direct.chunk[d] = cfg.chunk[d];
+        direct.offset[d] = start[d + 1];
+    }
+    direct.threads = cfg.direct_chunk;
+    direct.deflate = cfg.deflate;
+    direct.compress_total = direct.bytes_in = direct.bytes_out = 0.0;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // initialize the test data to MPI rank; streaming, only one slab is
+    // held at a time
+    size_t slab_elements = (size_t) slab_rows * cfg.domain[1] * cfg.domain[2];
+    vector<float> v(slab_elements, (float) mpi_rank);
+
+    // if we're loading a function, use it here, now, or for every slab of
+    // every timestep when streaming
+
+    double fill_time = 0.0, fill_init_time = 0.0;
+    double fill_shared_bytes = 0.0;
+    bool plugin_fill = strcmp(cfg.use_function_name, "") != 0 && !is_server;
+    block_fill fill;
+    if (plugin_fill) {
+
+        double start_fill = MPI_Wtime();
+        open_block_fill(fill, cfg, mpi_rank, domain_block_number);
+        fill_init_time = fill.init_time;
+        fill_shared_bytes = (double) fill.shared_bytes;
+        if (!cfg.memory_budget)
+        {
+            fill_rows(fill, 0, cfg.domain[0], &v[0]);
+            close_block_fill(fill);
+        }
+        fill_time = MPI_Wtime() - start_fill;
+    }
+    double max_fill_time = 0.0, max_fill_init_time = 0.0;
+    MPI_Reduce(&fill_time, &max_fill_time, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce(&fill_init_time, &max_fill_init_time, 1, MPI_DOUBLE, MPI_MAX, 0, 
+            comm);
+
+    // element types: the values are scaled, and held in the memory type when
+    // that isn't float; converted to the file type here rather than by 
+    // HDF5 with own_conversion. Streaming, slab by slab as they are filled.
+    hid_t mem_type = element_hdf5_type(cfg.memory_type, false);
+    vector<char> memory;
+    if (cfg.memory_type != ELEMENT_F32)
+        memory.resize(slab_elements * element_size(cfg.memory_type));
+    element_conversion conversion = {cfg.memory_type, cfg.file_type, 
+        H5I_INVALID_HID, vector<char>(), 0.0};
+    element_conversion* convert = NULL;
+    if (cfg.own_conversion)
+    {
+        conversion.type = element_hdf5_type(cfg.file_type, false);
+        conversion.buffer.resize(slab_elements * element_size(cfg.file_type));
+        convert = &conversion;
+    }
+    const void* block_buffer = memory.empty() ? (const void*) &v[0] : &memory[0];
+    if (!cfg.memory_budget)
+        prepare_elements(cfg.memory_type, type_scale, v, memory, v.size());
+
+    // with a halo the block is copied into the padded array once, with NaN
+    // around it, which would show in the file if anything but the interior
+    // were written
+    halo_layout halo;
+    halo.width = cfg.halo;
+    halo.mspace = H5I_INVALID_HID;
+    halo.pack = cfg.halo_pack != 0;
+    halo.elapsed = 0.0;
+    for (int d = 0; d < 3; d++)
+    {
+        halo.interior[d] = cfg.domain[d];
+        halo.dims[d] = cfg.domain[d] + 2 * halo.width;
+    }
+    if (cfg.halo)
+    {
+        halo.padded.assign(halo.dims[0] * halo.dims[1] * halo.dims[2], 
+                numeric_limits<float>::quiet_NaN());
+        for (hsize_t i = 0; i < halo.interior[0]; i++)
+        for (hsize_t j = 0; j < halo.interior[1]; j++)
+            copy(&v[(i * halo.interior[1] + j) * halo.interior[2]], 
+                    &v[(i * halo.interior[1] + j) * halo.interior[2]] + 
+                    halo.interior[2], &halo.padded[((i + halo.width) * 
+                        halo.dims[1] + j + halo.width) * halo.dims[2] + halo.width]);
+        hsize_t padded_dims[4] = {1, halo.dims[0], halo.dims[1], halo.dims[2]};
+        hsize_t interior_start[4] = {0, halo.width, halo.width, halo.width};
+        halo.mspace = H5Screate_simple(4, padded_dims, NULL);
+        assert(halo.mspace >= 0);
+        herr_retval = H5Sselect_hyperslab(halo.mspace, H5S_SELECT_SET, 
+                interior_start, NULL, count, block);
+        assert(herr_retval >= 0);
+        if (halo.pack) halo.packed.resize(v.size());
+    }
+
+    // data a plugin maps shared is held once per node, not once per rank:
+    // what a private copy on every rank would have cost on top of that one
+    double fill_shared_max = 0.0, fill_saved_max = 0.0;
+    if (strcmp(cfg.use_function_name, "") != 0)
+    {
+        MPI_Comm fill_node_comm;
+        mpi_retval = MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED,
+                mpi_rank, MPI_INFO_NULL, &fill_node_comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        double node_sum = 0.0, node_max = 0.0;
+        MPI_Allreduce(&fill_shared_bytes, &node_sum, 1, MPI_DOUBLE, MPI_SUM, 
+                fill_node_comm);
+        MPI_Allreduce(&fill_shared_bytes, &node_max, 1, MPI_DOUBLE, MPI_MAX, 
+                fill_node_comm);
+        MPI_Comm_free(&fill_node_comm);
+        double saved = node_sum - node_max;
+        MPI_Reduce(&fill_shared_bytes, &fill_shared_max, 1, MPI_DOUBLE, MPI_MAX,
+                0, comm);
+        MPI_Reduce(&saved, &fill_saved_max, 1, MPI_DOUBLE, MPI_MAX, 0, 
+                comm);
     }
   
     // create the fapl
     hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
     assert(fapl >= 0);
 
-    // use the latest file format
-    herr_retval = H5Pset_libver_bounds(fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
-    assert (herr_retval >= 0);
+    // use the latest file format
+    herr_retval = H5Pset_libver_bounds(fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+    assert (herr_retval >= 0);
+
+    // metadata tuning
+    hid_t fcpl = H5Pcreate(H5P_FILE_CREATE);
+    assert(fcpl >= 0);
+    bool evict_on_close_set = set_metadata_tuning(cfg, fcpl, fapl);
+    if (cfg.evict_on_close && !evict_on_close_set && mpi_rank == 0)
+        printf("evict_on_close is not supported by this HDF5, ignored.\n");
+
+    // align objects, chunks in particular, to stripes: to the explicit 
+    // alignment, or else the stripe size; by default everything at least as
+    // big as a chunk, or the alignment if that is smaller, is aligned
+    hsize_t alignment = cfg.align[0] ? cfg.align[0] : cfg.lfs_stripe_size;
+    hsize_t align_threshold = cfg.align[1];
+    if (alignment && !align_threshold)
+        align_threshold = min(alignment, 
+                cfg.chunk[0] * cfg.chunk[1] * cfg.chunk[2] * 
+                element_size(cfg.file_type));
+    if (alignment)
+    {
+        herr_retval = H5Pset_alignment(fapl, align_threshold, alignment);
+        assert (herr_retval >= 0);
+    }
+
+    // process 0 creates precreated files on its own, with the page buffer
+    // that parallel HDF5 does not support
+    hid_t serial_fapl = H5Pcopy(fapl);
+    assert(serial_fapl >= 0);
+    if (cfg.page_buffer_size)
+    {
+        herr_retval = H5Pset_page_buffer_size(serial_fapl, cfg.page_buffer_size, 0, 0);
+        assert (herr_retval >= 0);
+    }
+
+    // set collective metadata reads
+    if (cfg.set_collective_metadata)
+    {
+        herr_retval = H5Pset_all_coll_metadata_ops(fapl, true);
+        assert (herr_retval >= 0 );
+        herr_retval = H5Pset_all_coll_metadata_ops(dapl, true);
+        assert (herr_retval >= 0 );
+    }
+
+    MPI_Info info;
+    if (cfg.collective_write)
+    {
+        // the same hints on every rank, blocks of different sizes or not
+        setMPI_Info(info, nominal_domain[0] * nominal_domain[1] * 
+                nominal_domain[2], mpi_size);
+    }
+    else
+    {
+        info = MPI_INFO_NULL;
+    }
+    if (cfg.lfs_stripe_size || cfg.lfs_stripe_count)
+    {
+        if (info == MPI_INFO_NULL) 
+        {
+            mpi_retval = MPI_Info_create(&info);
+            assert(mpi_retval == MPI_SUCCESS);
+        }
+        setStriping_Info(info, cfg.lfs_stripe_count, cfg.lfs_stripe_size);
+    }
+
+    herr_retval = H5Pset_fapl_mpio(fapl, file_comm, info);
+    assert (herr_retval >= 0);
+#ifdef H5_HAVE_SUBFILING_VFD
+    if (cfg.subfiling && !set_fapl_subfiling(fapl, cfg, file_comm, info))
+    {
+        if (mpi_rank==0) printf("HDF5 rejected the subfiling configuration, "
+                "stripe size %llu, I/O concentrators \"%s\"\nExiting.\n",
+                (unsigned long long) cfg.subfiling_stripe_size, 
+                cfg.subfiling_ioc);
+        exit(126);
+    }
+#endif
+
+    // the fapl keeps its own copy of the hints; the results store gets them
+    // as they were set
+    string environment;
+    if (mpi_rank == 0 && cfg.results_file[0]) 
+        environment = results_environment(info);
+    if (info != MPI_INFO_NULL)
+    {
+        mpi_retval = MPI_Info_free(&info);
+        assert(mpi_retval == MPI_SUCCESS);
+    }
+
+    if (cfg.subfile) 
+    {
+#ifdef H5_SUBFILING
+
+        MPI_Comm subfile_comm;
+        char subfile_name[256];
+
+        // split by color
+        int color = mpi_rank % cfg.subfile;
+        // group io on nodes
+        if (cfg.n_nodes > cfg.subfile) color = (mpi_rank % cfg.n_nodes) % cfg.subfile;
+        MPI_Comm_split (comm, color, mpi_rank, &subfile_comm);
+        sprintf(subfile_name, "Subfile_%d.h5", color);
+        herr_retval = H5Pset_subfiling_access(fapl, subfile_name, subfile_comm, MPI_INFO_NULL);
+        assert (herr_retval >= 0); 
+        
+        // select hyperslab for subfiling, superset of selection for writing.
+        hsize_t subfiling_block[] = {cfg.simulation_time, cfg.domain[0], cfg.domain[1], cfg.domain[2]};
+        hsize_t subfiling_start[] = {0, start[1], start[2], start[3]};
+        herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, subfiling_start, NULL, count, subfiling_block);
+        assert (herr_retval >= 0);
+        herr_retval = H5Pset_subfiling_selection(dapl, fspace);
+        assert (herr_retval >= 0); 
+#else 
+        cout << "Warning:  Subfilng requested but library not built with subfiling. " << endl;
+        cout << "          Ignoring subfiling directives. " << endl << endl;
+#endif
+
+    }
+
+    // file handle and name for file which will be created
+    hid_t file = H5I_INVALID_HID, dset_chunked = H5I_INVALID_HID;
+    vector<hid_t> dsets(cfg.variables, H5I_INVALID_HID);
+
+    MPI_Barrier(comm);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // precreate datasets, as needed
+    double start_create = MPI_Wtime();
+    double create_1=0.0f, create_2=0.0f, create_3=0.0f;
+
+    if (cfg.precreate)
+    {
+        // create with process 0, or the first of the group, then close & 
+        // re-open
+        if (cfg.file_groups ? file_rank == 0 : mpi_rank == 0)
+        {
+            precreate_0(file_name.c_str(), fspace, dcpl, cfg.variables, fcpl, 
+                    serial_fapl, file_type);
+        }
+        MPI_Barrier(comm);
+        create_1 = MPI_Wtime();
+        if (writes_file)
+        {
+            file = H5Fopen(file_name.c_str(), H5F_ACC_RDWR, fapl);
+            assert (file >= 0);
+        }
+        MPI_Barrier(comm);
+        create_2 = MPI_Wtime();
+        if (writes_file)
+        {
+            for (int i = 0; i < cfg.variables; i++)
+            {
+                dsets[i] = H5Dopen(file, variable_dset_name(i).c_str(), dapl);
+                assert(dsets[i] >= 0);
+            }
+            dset_chunked = dsets[0];
+        }
+        MPI_Barrier(comm);
+        create_3 = MPI_Wtime();
+    }
+    else if (writes_file)
+    {
+        file = H5Fcreate(file_name.c_str(), H5F_ACC_TRUNC, fcpl, fapl);
+        assert(file >= 0);
+#ifdef H5_HAVE_SUBFILING_VFD
+        if (cfg.subfiling) clear_subfiling_environment(cfg);
+#endif
+        for (int i = 0; i < cfg.variables; i++)
+        {
+            dsets[i] = H5Dcreate(file, variable_dset_name(i).c_str(), 
+                    file_type, fspace, H5P_DEFAULT, dcpl, dapl);
+            assert(dsets[i] >= 0);
+        }
+        dset_chunked = dsets[0];
+    }
+
+    MPI_Barrier(comm);
+    double stop_create = MPI_Wtime();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // write the chunked dataset
+
+    // double buffers for the compute phase; step N is written from 
+    // state[N % 2] while step N+1 is computed into the other one
+    bool emulate_compute = (cfg.compute_time > 0.0 || cfg.async_write);
+    vector<float> state[2];
+    hid_t step_fspace[2] = {fspace, fspace};
+    if (emulate_compute && !cfg.io_servers && !cfg.node_aggregate)
+    {
+        state[0].resize(v.size());
+        if (cfg.async_write) 
+        {
+            state[1].resize(v.size());
+            step_fspace[1] = H5Scopy(fspace);
+            assert (step_fspace[1] >= 0);
+        }
+    }
+    double compute_total = 0.0, io_total = 0.0;
+
+    // time spent writing each timestep on this rank
+    vector<double> step_time(cfg.simulation_time, 0.0);
+
+    // time spent growing the datasets by each timestep, with extend_time
+    vector<double> extend_step(cfg.simulation_time, 0.0);
+
+    // digest of this rank's block for every timestep
+    vector<uint64_t> digests(cfg.simulation_time, 0);
+    double digest_total = 0.0;
+
+    // with I/O servers: time spent receiving on the servers, and the blocks
+    // the servers write the digests of
+    double receive_total = 0.0;
+    vector<hsize_t> digest_blocks(domain_block_number, domain_block_number + 3);
+
+    // with node aggregation: copying in and waiting, and the leader's copying
+    // out of the window
+    double stall_total = 0.0, pack_total = 0.0;
+
+    // streaming: time spent making slabs with the fill plugin
+    double generate_total = 0.0;
+
+    MPI_Barrier(comm);
+    double start_chunked = MPI_Wtime();
+
+    if (cfg.io_servers && is_server)
+    {
+        int server = mpi_rank - processor_count;
+        vector<int> clients;
+        for (int c = 0; c < processor_count; c++)
+        {
+            hsize_t number[3];
+            block_of_rank(c, cfg.processor, number);
+            if (forwarding_server(number[0], cfg.processor[0], cfg.io_servers) == server)
+                clients.push_back(c);
+        }
+        serve_timesteps(cfg, comm, dset_chunked, dxpl, server, clients, step_time, 
+                extend_step, receive_total);
+        for (size_t it = 0; it < cfg.simulation_time; ++it) io_total += step_time[it];
+
+        // the clients computed the digests, the servers store them
+        if (cfg.digest)
+        {
+            digests.resize(clients.size() * cfg.simulation_time);
+            digest_blocks.resize(3 * clients.size());
+            for (size_t c = 0; c < clients.size(); c++)
+            {
+                block_of_rank(clients[c], cfg.processor, &digest_blocks[3 * c]);
+                mpi_retval = MPI_Recv(&digests[c * cfg.simulation_time], 
+                        cfg.simulation_time, MPI_UINT64_T, clients[c], 
+                        cfg.simulation_time, comm, MPI_STATUS_IGNORE);
+                assert(mpi_retval == MPI_SUCCESS);
+            }
+        }
+    }
+    else if (cfg.io_servers)
+    {
+        int server_rank = processor_count + 
+            forwarding_server(domain_block_number[0], cfg.processor[0], cfg.io_servers);
+        forward_timesteps(cfg, comm, v, server_rank, step_time, digests, compute_total,
+                digest_total);
+        for (size_t it = 0; it < cfg.simulation_time; ++it) io_total += step_time[it];
+        if (cfg.digest)
+        {
+            mpi_retval = MPI_Send(&digests[0], cfg.simulation_time, MPI_UINT64_T,
+                    server_rank, cfg.simulation_time, comm);
+            assert(mpi_retval == MPI_SUCCESS);
+        }
+    }
+    else if (cfg.node_aggregate)
+    {
+        int node_size;
+        MPI_Comm_size(node_comm, &node_size);
+        vector<hsize_t> node_blocks(writes_file ? 3 * node_size : 0);
+        mpi_retval = MPI_Gather(domain_block_number, 3, MPI_UNSIGNED_LONG_LONG, 
+                node_blocks.data(), 3, MPI_UNSIGNED_LONG_LONG, 0, node_comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        aggregate_timesteps(cfg, v, node_comm, dset_chunked, dxpl, step_time, 
+                extend_step, digests, node_blocks, compute_total, digest_total, stall_total, 
+                pack_total);
+        for (size_t it = 0; it < cfg.simulation_time; ++it) io_total += step_time[it];
+
+        // the leaders store the digests of their node
+        if (cfg.digest)
+        {
+            vector<uint64_t> node_digests(node_blocks.size() / 3 * cfg.simulation_time);
+            mpi_retval = MPI_Gather(&digests[0], cfg.simulation_time, MPI_UINT64_T,
+                    node_digests.data(), cfg.simulation_time, MPI_UINT64_T, 0, node_comm);
+            assert(mpi_retval == MPI_SUCCESS);
+            digests.swap(node_digests);
+            digest_blocks.swap(node_blocks);
+        }
+    }
+    else if (cfg.memory_budget)
+    {
+        // every timestep is written slab by slab, the last one possibly 
+        // shorter; all ranks write as many slabs, so they can be collective
+        hsize_t slab_dims[4] = {1, slab_rows, cfg.domain[1], cfg.domain[2]};
+        hid_t slab_mspace = H5Screate_simple(n_dims, slab_dims, NULL);
+        assert(slab_mspace >= 0);
+        hsize_t slab_start[4] = {0, 0, start[2], start[3]};
+        hsize_t slab_block[4] = {1, slab_rows, cfg.domain[1], cfg.domain[2]};
+        hsize_t origin[4] = {0, 0, 0, 0};
+        for (size_t it = 0; it < cfg.simulation_time; ++it)
+        {
+            if (cfg.extend_time)
+                extend_step[it] = extend_time_dimension(&dsets[0], cfg.variables, 
+                        fspace, it + 1);
+            seism_core_digest_state digest_state;
+            seism_core_digest_init(&digest_state);
+            for (hsize_t row = 0; row < cfg.domain[0]; row += slab_rows)
+            {
+                slab_block[1] = min(slab_rows, cfg.domain[0] - row);
+                size_t n_elements = slab_block[1] * cfg.domain[1] * cfg.domain[2];
+                if (plugin_fill)
+                {
+                    double start_slab = MPI_Wtime();
+                    fill_rows(fill, row, row + slab_block[1], &v[0]);
+                    prepare_elements(cfg.memory_type, type_scale, v, memory, 
+                            n_elements);
+                    generate_total += MPI_Wtime() - start_slab;
+                }
+                else if (!row && !it)
+                    prepare_elements(cfg.memory_type, type_scale, v, memory, 
+                            v.size());
+                if (cfg.digest)
+                {
+                    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+                    seism_core_digest_update(&digest_state, &v[0], 
+                            n_elements * sizeof(float));
+                    digest_total += chrono::duration<double>(
+                            chrono::steady_clock::now() - t0).count();
+                }
+                slab_start[0] = (hsize_t) it;
+                slab_start[1] = start[1] + row;
+                herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, 
+                        slab_start, NULL, count, slab_block);
+                assert (herr_retval >= 0);
+                herr_retval = H5Sselect_hyperslab(slab_mspace, H5S_SELECT_SET, 
+                        origin, NULL, count, slab_block);
+                assert (herr_retval >= 0);
+                timestep_write w = make_timestep_write(&dsets[0], 
+                        slab_mspace, fspace, dxpl, block_buffer);
+                w.n_elements = n_elements;
+                w.mem_type = mem_type;
+                w.convert = convert;
+                w.n_dsets = cfg.variables;
+                w.multi = cfg.multi_dataset;
+                write_timestep(&w);
+                step_time[it] += w.elapsed;
+            }
+            if (cfg.digest) digests[it] = seism_core_digest_final(&digest_state);
+            io_total += step_time[it];
+        }
+        herr_retval = H5Sclose(slab_mspace);
+        assert (herr_retval >= 0);
+        if (plugin_fill) close_block_fill(fill);
+    }
+    else if (!emulate_compute)
+    {
+        for (size_t it = 0; it < cfg.simulation_time; ++it)
+        {
+            if (cfg.extend_time)
+                extend_step[it] = extend_time_dimension(&dsets[0], cfg.variables, 
+                        fspace, it + 1);
+            start[0] = (hsize_t) it;
+            herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, NULL, count, block);
+            assert (herr_retval >= 0);
+            timestep_write w = make_timestep_write(&dsets[0], mspace, 
+                    fspace, dxpl, block_buffer);
+            w.n_elements = v.size();
+            w.mem_type = mem_type;
+            w.convert = convert;
+            if (cfg.halo) w.halo = &halo;
+            w.n_dsets = cfg.variables;
+            w.multi = cfg.multi_dataset;
+            if (cfg.direct_chunk) w.direct = &direct;
+            w.step = it;
+            if (cfg.digest) w.digest = &digests[it];
+            write_timestep(&w);
+            step_time[it] = w.elapsed;
+            digest_total += w.digest_elapsed;
+        }
+    }
+    else if (!cfg.async_write)
+    {
+        // compute, then write, with nothing hidden
+        for (size_t it = 0; it < cfg.simulation_time; ++it)
+        {
+            compute_total += compute_phase(state[0], v, cfg.compute_time);
+            if (cfg.extend_time)
+                extend_step[it] = extend_time_dimension(&dsets[0], cfg.variables, 
+                        fspace, it + 1);
+            start[0] = (hsize_t) it;
+            herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, NULL, count, block);
+            assert (herr_retval >= 0);
+            timestep_write w = make_timestep_write(&dsets[0], mspace, 
+                    fspace, dxpl, &state[0][0]);
+            w.n_elements = v.size();
+            w.mem_type = mem_type;
+            w.convert = convert;
+            w.n_dsets = cfg.variables;
+            w.multi = cfg.multi_dataset;
+            if (cfg.direct_chunk) w.direct = &direct;
+            w.step = it;
+            if (cfg.digest) w.digest = &digests[it];
+            write_timestep(&w);
+            step_time[it] = w.elapsed;
+            digest_total += w.digest_elapsed;
+            io_total += w.elapsed;
+        }
+    }
+    else
+    {
+#if H5_VERSION_GE(1,13,0)
+        hid_t es = H5I_INVALID_HID;
+        double es_exec = 0.0;
+        if (use_event_set)
+        {
+            es = H5EScreate();
+            assert (es >= 0);
+            herr_retval = H5ESregister_complete_func(es, event_complete, &es_exec);
+            assert (herr_retval >= 0);
+        }
+#endif
+        compute_total += compute_phase(state[0], v, cfg.compute_time);
+        for (size_t it = 0; it < cfg.simulation_time; ++it)
+        {
+            int b = it % 2;
+            if (cfg.extend_time)
+                extend_step[it] = extend_time_dimension(&dsets[0], cfg.variables, 
+                        step_fspace[b], it + 1);
+            start[0] = (hsize_t) it;
+            herr_retval = H5Sselect_hyperslab(step_fspace[b], H5S_SELECT_SET, start, NULL, count, block);
+            assert (herr_retval >= 0);
+            timestep_write w = make_timestep_write(&dsets[0], mspace, 
+                    step_fspace[b], dxpl, &state[b][0]);
+            w.n_elements = v.size();
+            w.mem_type = mem_type;
+            w.convert = convert;
+            w.n_dsets = cfg.variables;
+            w.multi = cfg.multi_dataset;
+            if (cfg.direct_chunk) w.direct = &direct;
+            w.step = it;
+            if (cfg.digest) w.digest = &digests[it];
+
+            thread io_thread;
+#if H5_VERSION_GE(1,13,0)
+            double es_issue = 0.0;
+            if (use_event_set)
+            {
+                es_issue = MPI_Wtime();
+                for (size_t i = 0; i < w.n_dsets; i++)
+                {
+                    herr_retval = H5Dwrite_async(w.dsets[i], w.mem_type, 
+                            w.mspace, w.fspace, w.dxpl, w.buf, es);
+                    assert (herr_retval >= 0);
+                }
+                es_issue = MPI_Wtime() - es_issue;
+                digest_timestep(&w);
+            }
+            else
+#endif
+            io_thread = thread(write_timestep, &w);
+
+            if (it + 1 < cfg.simulation_time) 
+                compute_total += compute_phase(state[1 - b], v, cfg.compute_time);
+
+#if H5_VERSION_GE(1,13,0)
+            if (use_event_set)
+            {
+                // only the exposed part, issue plus wait, is visible here
+                double es_wait = MPI_Wtime();
+                size_t num_in_progress;
+                hbool_t op_failed;
+                herr_retval = H5ESwait(es, H5ES_WAIT_FOREVER, &num_in_progress, &op_failed);
+                assert (herr_retval >= 0 && !op_failed);
+                step_time[it] = es_issue + MPI_Wtime() - es_wait;
+            }
+            else
+#endif
+            {
+                io_thread.join();
+                step_time[it] = w.elapsed;
+                io_total += w.elapsed;
+            }
+            digest_total += w.digest_elapsed;
+        }
+#if H5_VERSION_GE(1,13,0)
+        if (use_event_set)
+        {
+            herr_retval = H5ESclose(es);
+            assert (herr_retval >= 0);
+            // the time the writes took on the connector's thread, 0 if it 
+            // doesn't say
+            io_total = es_exec;
+        }
+#endif
+    }
+
+    MPI_Barrier(comm);
+    double stop_chunked = MPI_Wtime();
 
-    // set collective metadata reads
-    if (set_collective_metadata)
+    // exposed I/O is whatever part of the loop was not spent computing; the
+    // slowest rank determines what the application would see
+    double exposed_io = (stop_chunked - start_chunked) - compute_total;
+    if (is_server) exposed_io = 0.0;
+    double max_exposed_io = 0.0, max_io_total = 0.0, max_compute_total = 0.0;
+    MPI_Reduce(&exposed_io, &max_exposed_io, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce(&io_total, &max_io_total, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce(&compute_total, &max_compute_total, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+    double max_generate_total = 0.0;
+    if (cfg.memory_budget)
+        MPI_Reduce(&generate_total, &max_generate_total, 1, MPI_DOUBLE, MPI_MAX, 
+                0, comm);
+
+    // direct chunk writes: slowest packing/deflating, and the totals
+    double max_compress_total = 0.0, direct_bytes[2] = {0.0, 0.0};
+    if (cfg.direct_chunk)
     {
-        herr_retval = H5Pset_all_coll_metadata_ops(fapl, true);
-        assert (herr_retval >= 0 );
-        herr_retval = H5Pset_all_coll_metadata_ops(dapl, true);
-        assert (herr_retval >= 0 );
+        double bytes[2] = {direct.bytes_in, direct.bytes_out};
+        MPI_Reduce(&direct.compress_total, &max_compress_total, 1, MPI_DOUBLE, 
+                MPI_MAX, 0, comm);
+        MPI_Reduce(bytes, direct_bytes, 2, MPI_DOUBLE, MPI_SUM, 0, comm);
     }
 
-    MPI_Info info;
-    if (collective_write)
+    // slowest extension of every timestep
+    vector<double> max_extend_step(cfg.simulation_time, 0.0);
+    if (cfg.extend_time)
+        MPI_Reduce(&extend_step[0], &max_extend_step[0], cfg.simulation_time, 
+                MPI_DOUBLE, MPI_MAX, 0, comm);
+
+    // with I/O servers, what the clients stalled for vs. what the servers 
+    // spent; with node aggregation, the same for ranks vs. node leaders
+    double client_stall = is_server ? 0.0 : io_total;
+    double server_write = is_server ? io_total : 0.0;
+    if (cfg.node_aggregate)
     {
-        setMPI_Info(info, v.size(), mpi_size);
+        client_stall = stall_total;
+        server_write = io_total;
+        receive_total = pack_total;
+        MPI_Comm_free(&node_comm);
     }
-    else
+    double max_client_stall = 0.0, max_server_write = 0.0, max_receive_total = 0.0;
+    if (cfg.io_servers || cfg.node_aggregate)
     {
-        info = MPI_INFO_NULL;
+        MPI_Reduce(&client_stall, &max_client_stall, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(&server_write, &max_server_write, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(&receive_total, &max_receive_total, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
     }
 
-    herr_retval = H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, info);
-    assert (herr_retval >= 0);
-
-    if (subfile) 
+    // gather per-rank, per-step write times and hostnames to process 0
+    vector<double> all_step_times;
+    vector<char> all_hosts;
+    char host[MPI_MAX_PROCESSOR_NAME];
+    memset(host, 0, MPI_MAX_PROCESSOR_NAME);
+    int host_len = 0;
+    MPI_Get_processor_name(host, &host_len);
+    if (mpi_rank == 0)
     {
-#ifdef H5_SUBFILING
-
-        MPI_Comm comm;
-        char subfile_name[256];
-
-        // split by color
-        int color = mpi_rank % subfile;
-        // group io on nodes
-        if (n_nodes > subfile) color = (mpi_rank % n_nodes) % subfile;
-        MPI_Comm_split (MPI_COMM_WORLD, color, mpi_rank, &comm);
-        sprintf(subfile_name, "Subfile_%d.h5", color);
-        herr_retval = H5Pset_subfiling_access(fapl, subfile_name, comm, MPI_INFO_NULL);
-        assert (herr_retval >= 0); 
-        
-        // select hyperslab for subfiling, superset of selection for writing.
-        hsize_t subfiling_block[] = {simulation_time, domain[0], domain[1], domain[2]};
-        hsize_t subfiling_start[] = {0, start[1], start[2], start[3]};
-        herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, subfiling_start, NULL, count, subfiling_block);
+        all_step_times.resize((size_t) mpi_size * cfg.simulation_time);
+        all_hosts.resize((size_t) mpi_size * MPI_MAX_PROCESSOR_NAME);
+    }
+    mpi_retval = MPI_Gather(&step_time[0], cfg.simulation_time, MPI_DOUBLE, 
+            all_step_times.data(), cfg.simulation_time, MPI_DOUBLE, 0, comm);
+    assert(mpi_retval == MPI_SUCCESS);
+    mpi_retval = MPI_Gather(host, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 
+            all_hosts.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, comm);
+    assert(mpi_retval == MPI_SUCCESS);
+    int local_writes_file = writes_file;
+    vector<int> all_writes_file(mpi_rank == 0 ? mpi_size : 0);
+    mpi_retval = MPI_Gather(&local_writes_file, 1, MPI_INT, all_writes_file.data(),
+            1, MPI_INT, 0, comm);
+    assert(mpi_retval == MPI_SUCCESS);
+    double local_bytes = (double) cfg.domain[0] * cfg.domain[1] * cfg.domain[2] *
+        cfg.simulation_time * element_size(cfg.file_type) * cfg.variables;
+    vector<double> all_bytes(mpi_rank == 0 ? mpi_size : 0);
+    mpi_retval = MPI_Gather(&local_bytes, 1, MPI_DOUBLE, all_bytes.data(), 1, 
+            MPI_DOUBLE, 0, comm);
+    assert(mpi_retval == MPI_SUCCESS);
+    if (cfg.async_write)
+    {
+        herr_retval = H5Sclose(step_fspace[1]);
         assert (herr_retval >= 0);
-        herr_retval = H5Pset_subfiling_selection(dapl, fspace);
-        assert (herr_retval >= 0); 
-#else 
-        cout << "Warning:  Subfilng requested but library not built with subfiling. " << endl;
-        cout << "          Ignoring subfiling directives. " << endl << endl;
-#endif
-
     }
 
-    // file handle and name for file which will be created
-    hid_t file, dset_chunked;
-
-    MPI_Barrier(MPI_COMM_WORLD);
-
     ///////////////////////////////////////////////////////////////////////////
-    // precreate datasets, as needed
-    double start_create = MPI_Wtime();
-    double create_1=0.0f, create_2=0.0f, create_3=0.0f;
 
-    if (precreate)
+    // get storage size before closing dataset; process 0 may not have it
+    hsize_t storage_size = 0;
+    if (writes_file) 
+        for (int i = 0; i < cfg.variables; i++) 
+            storage_size += H5Dget_storage_size(dsets[i]);
+    if (cfg.io_servers || cfg.node_aggregate)
     {
-        if (mpi_rank == 0) // create with process 0, then close & re-open
-        {
-            precreate_0(filename, fspace, dcpl);
-        }
-        MPI_Barrier(MPI_COMM_WORLD);
-        create_1 = MPI_Wtime();
-        file = H5Fopen(filename, H5F_ACC_RDWR, fapl);
-        assert (file >= 0);
-        MPI_Barrier(MPI_COMM_WORLD);
-        create_2 = MPI_Wtime();
-        dset_chunked = H5Dopen(file, CHUNKED_DSET_NAME, dapl);
-        assert(dset_chunked >= 0);
-        MPI_Barrier(MPI_COMM_WORLD);
-        create_3 = MPI_Wtime();
+        unsigned long long local_size = storage_size, max_size = 0;
+        MPI_Reduce(&local_size, &max_size, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, 0, comm);
+        storage_size = max_size;
     }
-    else
+    else if (cfg.file_groups)
     {
-        file = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
-        assert(file >= 0);
-        dset_chunked = H5Dcreate(file, CHUNKED_DSET_NAME, H5T_IEEE_F32LE, 
-                fspace, H5P_DEFAULT, dcpl, dapl);
-        assert(dset_chunked >= 0);
+        // the sum of the piece files
+        unsigned long long local_size = file_rank ? 0 : storage_size, sum = 0;
+        MPI_Reduce(&local_size, &sum, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, comm);
+        storage_size = sum;
     }
 
-    MPI_Barrier(MPI_COMM_WORLD);
-    double stop_create = MPI_Wtime();
+    // every growing prefix of the filter chain on this rank's block, and the
+    // error of the whole chain; I/O servers have no block of their own
+    size_t n_stages = cfg.subfile ? 0 : stages.size();
+    vector<filter_benchmark> filter_totals(n_stages);
+    double error_max = 0.0, error_sum_sq = 0.0, range[2] = {0.0, 0.0};
+    for (size_t n = 1; n <= n_stages; n++)
+    {
+        filter_benchmark fb = {0.0, 0.0, 0.0, 0.0};
+        vector<float> read_back;
+        if (!is_server) 
+        {
+            // on what's in the buffer: the block, or the last slab
+            hsize_t buffer_dims[3] = {slab_rows, cfg.domain[1], cfg.domain[2]};
+            fb = benchmark_filters(stages, n, cfg.chunk, buffer_dims, 
+                    cfg.file_type, v, read_back);
+        }
+        MPI_Reduce(&fb, &filter_totals[n - 1], 4, MPI_DOUBLE, MPI_SUM, 0, 
+                comm);
+        if (n < n_stages) continue;
 
-    ///////////////////////////////////////////////////////////////////////////
-    // write the chunked dataset
+        double local_max = 0.0, local_sum_sq = 0.0;
+        double local_range[2] = {-HUGE_VAL, -HUGE_VAL}; // -min, max
+        for (size_t i = 0; i < read_back.size(); i++)
+        {
+            double error = fabs((double) read_back[i] - v[i]);
+            local_max = max(local_max, error);
+            local_sum_sq += error * error;
+            local_range[0] = max(local_range[0], (double) -v[i]);
+            local_range[1] = max(local_range[1], (double) v[i]);
+        }
+        MPI_Reduce(&local_max, &error_max, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(&local_sum_sq, &error_sum_sq, 1, MPI_DOUBLE, MPI_SUM, 0, 
+                comm);
+        MPI_Reduce(local_range, range, 2, MPI_DOUBLE, MPI_MAX, 0, comm);
+    }
 
-    MPI_Barrier(MPI_COMM_WORLD);
-    double start_chunked = MPI_Wtime();
+    // the conversion between the element types, on what's in the buffer
+    conversion_benchmark conversion_max = {0.0, 0.0, 0.0};
+    double conversion_differences = 0.0, own_conversion_max = 0.0;
+    if (convert_types)
+    {
+        conversion_benchmark cb = benchmark_conversion(cfg.memory_type, 
+                cfg.file_type, block_buffer, v.size());
+        MPI_Reduce(&cb, &conversion_max, 2, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(&cb.differences, &conversion_differences, 1, MPI_DOUBLE, 
+                MPI_SUM, 0, comm);
+        MPI_Reduce(&conversion.elapsed, &own_conversion_max, 1, MPI_DOUBLE, 
+                MPI_MAX, 0, comm);
+    }
+    if (conversion.type >= 0) H5Tclose(conversion.type);
+    H5Tclose(mem_type);
 
-    for (size_t it = 0; it < simulation_time; ++it)
+    // walking the memory selection against packing, and the packing done
+    double halo_max[2] = {0.0, 0.0}, halo_pack_max = 0.0;
+    if (cfg.halo)
     {
-        start[0] = (hsize_t) it;
-        herr_retval = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, NULL, count, block);
-        assert (herr_retval >= 0);
-        herr_retval = H5Dwrite(dset_chunked, H5T_NATIVE_FLOAT, mspace, fspace, dxpl, &v[0]);
-        assert (herr_retval >= 0);
+        double halo_time[2];
+        benchmark_halo(halo, halo_time);
+        MPI_Reduce(halo_time, halo_max, 2, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(&halo.elapsed, &halo_pack_max, 1, MPI_DOUBLE, MPI_MAX, 0, 
+                comm);
+        herr_retval = H5Sclose(halo.mspace);
+        assert(herr_retval >= 0);
     }
 
-    MPI_Barrier(MPI_COMM_WORLD);
-    double stop_chunked = MPI_Wtime();
+    // how many chunks start on an alignment boundary, counted by the first
+    // writer of every file and summed over the files
+    unsigned long long chunk_counts[2] = {0, 0}, total_chunk_counts[2] = {0, 0};
+    int file_comm_rank = 0;
+    if (writes_file) MPI_Comm_rank(file_comm, &file_comm_rank);
+    if (alignment && writes_file && file_comm_rank == 0 && !cfg.subfile)
+    {
+        for (int i = 0; i < cfg.variables; i++)
+        {
+            hsize_t n_chunks, n_aligned;
+            count_aligned_chunks(dsets[i], alignment, n_chunks, n_aligned);
+            chunk_counts[0] += n_chunks;
+            chunk_counts[1] += n_aligned;
+        }
+    }
+    if (alignment)
+        MPI_Reduce(chunk_counts, total_chunk_counts, 2, MPI_UNSIGNED_LONG_LONG, 
+                MPI_SUM, 0, comm);
 
-    ///////////////////////////////////////////////////////////////////////////
+    // with piece files, process 0 stores all digests next to the virtual 
+    // datasets
+    double max_digest_total = 0.0;
+    vector<uint64_t> all_digests;
+    if (cfg.digest)
+    {
+        if (cfg.file_groups)
+        {
+            all_digests.resize(mpi_rank == 0 ? mpi_size * cfg.simulation_time : 0);
+            mpi_retval = MPI_Gather(&digests[0], cfg.simulation_time, 
+                    MPI_UINT64_T, all_digests.data(), cfg.simulation_time,
+                    MPI_UINT64_T, 0, comm);
+            assert(mpi_retval == MPI_SUCCESS);
+        }
+        else if (writes_file)
+            write_digests(file, cfg.simulation_time, cfg.processor, 
+                    digest_blocks, digests, dxpl);
+        MPI_Reduce(&digest_total, &max_digest_total, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    }
 
-    // get storage size before closing dataset
-    hsize_t storage_size = H5Dget_storage_size(dset_chunked);
+    // only the subfiling VFD opens a subfiled file, and it does so in 
+    // parallel, so its attributes are written now, collectively, with the 
+    // same values everywhere
+    if (cfg.subfiling && writes_file)
+        write_simulation_attributes(file, cfg, nominal_domain, 
+                evict_on_close_set, type_scale, decomposition, pieces.n_files);
 
-    herr_retval = H5Dclose(dset_chunked);
-    assert (herr_retval >= 0);
+    if (writes_file)
+    {
+        for (int i = 0; i < cfg.variables; i++)
+        {
+            herr_retval = H5Dclose(dsets[i]);
+            assert (herr_retval >= 0);
+        }
+    }
     herr_retval = H5Pclose(fapl);
     assert (herr_retval >= 0);
+    herr_retval = H5Pclose(serial_fapl);
+    assert (herr_retval >= 0);
+    herr_retval = H5Pclose(fcpl);
+    assert (herr_retval >= 0);
     herr_retval = H5Sclose(mspace);
     assert (herr_retval >= 0);
     herr_retval = H5Pclose(dxpl);
@@ -609,9 +4585,11 @@ int main(int argc, char** argv)
     assert (herr_retval >= 0);
     herr_retval = H5Pclose(dcpl);
     assert (herr_retval >= 0);
+    if (file_type != element_file_type) H5Tclose(file_type);
+    H5Tclose(element_file_type);
 
 #ifdef INCLUDE_ZFP
-    if (zfp != 0)
+    if (use_zfp)
     {
          herr_retval = H5Z_zfp_finalize();
          assert (herr_retval >= 0);
@@ -625,21 +4603,55 @@ int main(int argc, char** argv)
     herr_retval = H5Pclose(dapl);
     assert (herr_retval >= 0);
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Barrier(comm);
     double fclose_start = MPI_Wtime();
 
-    herr_retval = H5Fclose(file);
-    assert (herr_retval >= 0);
+    if (writes_file)
+    {
+        herr_retval = H5Fclose(file);
+        assert (herr_retval >= 0);
+    }
+    if (cfg.io_servers || cfg.node_aggregate || cfg.file_groups) 
+        MPI_Comm_free(&file_comm);
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Barrier(comm);
     double fclose_stop = MPI_Wtime();
 
+    // stitch the piece files together, then read every block through the 
+    // virtual dataset and straight from its piece file
+    double virtual_time = 0.0, read_max[2] = {0.0, 0.0};
+    size_t n_mappings = 0;
+    if (cfg.file_groups)
+    {
+        if (mpi_rank == 0)
+            n_mappings = create_virtual_datasets(cfg, decomposition, pieces, 
+                    all_digests);
+        MPI_Barrier(comm);
+        virtual_time = MPI_Wtime() - fclose_stop;
+
+        hsize_t block_start[3];
+        for (int d = 0; d < 3; d++) block_start[d] = start[d + 1];
+        double read_time[2];
+        read_time[1] = time_block_read(file_name.c_str(), block_start, 
+                cfg.domain, cfg.simulation_time, cfg.file_type);
+        for (int d = 0; d < 3; d++) 
+            block_start[d] += pieces.start[3 * file_number + d];
+        read_time[0] = time_block_read(cfg.filename, block_start, cfg.domain, 
+                cfg.simulation_time, cfg.file_type);
+        MPI_Reduce(read_time, read_max, 2, MPI_DOUBLE, MPI_MAX, 0, comm);
+    }
+
+    copy(nominal_domain, nominal_domain + 3, cfg.domain);
+
     if (mpi_rank == 0)
     {
-        size_t bytes_written = simulation_time * processor[0] * domain[0] *
-          processor[1] * domain[1] *  processor[2] * domain[2] * sizeof(float);
+        size_t bytes_written = cfg.simulation_time * 
+          decomposition_extent(decomposition, 0) * 
+          decomposition_extent(decomposition, 1) * 
+          decomposition_extent(decomposition, 2) * 
+          element_size(cfg.file_type) * cfg.variables;
 
-        if (precreate)
+        if (cfg.precreate)
         {
             cout << "Pre-c";
         }
@@ -648,9 +4660,9 @@ int main(int argc, char** argv)
             cout << "C";
         }
         cout << "reate/open:\t\t";
-        if (!precreate) { cout << "\t";}
+        if (!cfg.precreate) { cout << "\t";}
         cout << (stop_create - start_create) << " s" << endl;
-        if (precreate)
+        if (cfg.precreate)
         {
             cout << "Time in precreate_0():\t\t"  << (create_1 - start_create) 
                  << " s" << endl;
@@ -659,45 +4671,577 @@ int main(int argc, char** argv)
             cout << "Time in H5Dopen():\t\t"  << (create_3 - create_2) 
                  << " s" << endl;
         }
-        cout << "Write:\t\t\t\t" <<
-          (stop_chunked - start_chunked) << " s" << endl;
+        if (strcmp(cfg.use_function_name, "") != 0)
+            cout << "Fill (" << cfg.use_function_name << "):\t\t" 
+                 << max_fill_time << " s" << endl;
+        if (max_fill_init_time > 0.0)
+            cout << "Fill init/load (max):\t\t" << max_fill_init_time << " s" 
+                 << endl;
+        if (fill_shared_max > 0.0)
+            cout << "Fill data shared:\t\t" << (size_t) fill_shared_max 
+                 << " bytes mapped, " << (size_t) fill_saved_max 
+                 << " bytes saved per node (max)" << endl;
+        // with a compute phase the loop time includes compute, so the raw
+        // write throughput is taken from time spent in H5Dwrite() instead,
+        // or from the exposed I/O when the event set hides that from us
+        double write_time = stop_chunked - start_chunked;
+        if (emulate_compute && !cfg.io_servers && !cfg.node_aggregate) 
+            write_time = use_event_set ? max_exposed_io : max_io_total;
+        // streaming, making the slabs doesn't count either
+        if (cfg.memory_budget) write_time = max_io_total;
+        cout << "Write:\t\t\t\t" << write_time << " s" << endl;
         cout << "Write throughput:\t\t" << bytes_written /
-          (stop_chunked - start_chunked) / ((double) (1<<20)) << " MB/s"
+          write_time / ((double) (1<<20)) << " MB/s"
              << endl;
+        if (cfg.variables > 1)
+        {
+            // how the fixed costs grow with the number of datasets
+            cout << "Create/open per variable:\t" 
+                 << (stop_create - start_create) / cfg.variables << " s" << endl;
+            cout << "Write per variable and step:\t" 
+                 << write_time / cfg.variables / cfg.simulation_time << " s" << endl;
+            cout << "Write calls per rank:\t\t" 
+                 << (cfg.multi_dataset ? 1 : cfg.variables) * cfg.simulation_time 
+                 << endl;
+        }
+        if (cfg.io_servers)
+        {
+            // clients only wait for their sends, servers for receive + write
+            cout << "Client stall (max):\t\t" << max_client_stall << " s" << endl;
+            cout << "Server receive wait (max):\t" << max_receive_total << " s" 
+                 << endl;
+            cout << "Server write (max):\t\t" << max_server_write << " s" << endl;
+            cout << "Server write throughput:\t" << bytes_written /
+              max_server_write / ((double) (1<<20)) << " MB/s" << endl;
+            if (emulate_compute)
+                cout << "Compute phase total:\t\t" << max_compute_total << " s" 
+                     << endl;
+        }
+        else if (cfg.node_aggregate)
+        {
+            // ranks wait for the leader to empty the window, not for the write
+            cout << "Node gather stall (max):\t" << max_client_stall << " s" << endl;
+            cout << "Leader copy-out (max):\t\t" << max_receive_total << " s" << endl;
+            cout << "Leader write (max):\t\t" << max_server_write << " s" << endl;
+            cout << "Leader write throughput:\t" << bytes_written /
+              max_server_write / ((double) (1<<20)) << " MB/s" << endl;
+            if (emulate_compute)
+                cout << "Compute phase total:\t\t" << max_compute_total << " s" 
+                     << endl;
+        }
+        else if (emulate_compute)
+        {
+            cout << "Timestep loop:\t\t\t" << (stop_chunked - start_chunked) 
+                 << " s" << endl;
+            cout << "Compute phase total:\t\t" << max_compute_total << " s" 
+                 << endl;
+            cout << "Exposed I/O:\t\t\t" << max_exposed_io << " s" << endl;
+            // with an event set the writes are timed by the connector, if
+            // it reports their execution times at all
+            cout << "Overlap efficiency:\t\t";
+            if (max_io_total > 0.0)
+            {
+                double overlap = 1.0 - max_exposed_io / max_io_total;
+                overlap = max(0.0, min(1.0, overlap));
+                cout << 100.0 * overlap << " %";
+                if (use_event_set) cout << " (event set)";
+            }
+            else if (use_event_set) 
+                cout << "n/a (no execution times from the connector)";
+            else cout << 0.0 << " %";
+            cout << endl;
+        }
+        if (cfg.memory_budget)
+        {
+            // the memory streaming saves, and the writes it takes
+            cout << "Slab buffer:\t\t\t" << v.size() * sizeof(float) << " bytes ("
+                 << 100.0 * slab_rows / cfg.domain[0] << " % of the block)" << endl;
+            cout << "Slab writes per step:\t\t" << n_slabs << endl;
+            if (strcmp(cfg.use_function_name, "") != 0)
+                cout << "Slab generation (max):\t\t" << max_generate_total << " s" 
+                     << endl;
+        }
+        if (cfg.direct_chunk)
+        {
+            // included in the write time above, the rest is H5Dwrite_chunk()
+            if (max_compress_total > 0.0)
+            {
+                cout << (cfg.deflate ? "Chunk deflate (max):\t\t" 
+                        : "Chunk packing (max):\t\t") << max_compress_total 
+                     << " s" << endl;
+                cout << (cfg.deflate ? "Deflate throughput:\t\t" 
+                        : "Packing throughput:\t\t") << direct_bytes[0] / 
+                    max_compress_total / ((double) (1<<20)) << " MB/s" << endl;
+            }
+            else cout << "Chunk packing:\t\t\tnone (zero copy)" << endl;
+            cout << "Direct chunk ratio:\t\t" << direct_bytes[0] / direct_bytes[1]
+                 << endl;
+        }
+        if (cfg.extend_time)
+        {
+            // included in the write time above; growth from the first to the
+            // last step shows what the chunk index and allocation cost
+            double extend_total = 0.0, extend_max = 0.0;
+            for (size_t it = 0; it < cfg.simulation_time; ++it)
+            {
+                extend_total += max_extend_step[it];
+                extend_max = max(extend_max, max_extend_step[it]);
+            }
+            cout << "Extend (H5Dset_extent):\t\t" << extend_total << " s" << endl;
+            cout << "Extend first/mean/last/max:\t" << max_extend_step.front() 
+                 << " / " << extend_total / cfg.simulation_time << " / " 
+                 << max_extend_step.back() << " / " << extend_max << " s" << endl;
+        }
+        if (cfg.digest)
+            cout << "Digest (" DIGEST_ALGORITHM "):\t\t\t" << max_digest_total 
+                 << " s" << endl;
         cout << "Close file:\t\t\t" << (fclose_stop - fclose_start) << " s"
              << endl;
+        if (cfg.file_groups)
+        {
+            // part of the output, so of the aggregate throughput too; the
+            // reads are of the first variable, the slowest rank's
+            double read_bytes = (double) bytes_written / cfg.variables;
+            cout << "Virtual dataset create:\t\t" << virtual_time << " s (" 
+                 << n_mappings << " mappings per variable)" << endl;
+            cout << "Read through VDS (max):\t\t" << read_max[0] << " s, " 
+                 << read_bytes / read_max[0] / ((double) (1<<20)) << " MB/s" 
+                 << endl;
+            cout << "Read from piece files (max):\t" << read_max[1] << " s, " 
+                 << read_bytes / read_max[1] / ((double) (1<<20)) << " MB/s" 
+                 << endl;
+        }
         cout << "Aggregate throughput:\t\t" << bytes_written /
-          (fclose_stop - begin) / ((double) (1<<20)) << " MB/s"
+          (fclose_stop - begin + virtual_time) / ((double) (1<<20)) << " MB/s"
              << endl;
         cout << "Mdata ops actually collective:\t" 
              << actual_metadata_ops_collective
              << endl;
 		cout << "Total bytes written:\t\t" << bytes_written << endl; 
 		cout << "Compressed size in bytes:\t" << storage_size << endl; 
+        if (n_stages)
+        {
+            // the filters alone, summed over the processes' blocks
+            cout << "Filter stage (in memory)\tratio\tcompress [MB/s]"
+                 << "\tdecompress [MB/s]" << endl;
+            for (size_t n = 0; n < n_stages; n++)
+            {
+                const filter_benchmark& fb = filter_totals[n];
+                string label = (n ? "+ " : "") + stages[n];
+                label.resize(max(label.size() + 1, (size_t) 32), ' ');
+                cout << label << fb.raw_bytes / fb.stored_bytes << "\t" 
+                     << fb.raw_bytes / fb.compress_time / ((double) (1<<20)) 
+                     << "\t\t" 
+                     << fb.raw_bytes / fb.decompress_time / ((double) (1<<20))
+                     << endl;
+            }
+            double n_values = filter_totals.back().raw_bytes / 
+                element_size(cfg.file_type);
+            double rmse = sqrt(error_sum_sq / n_values);
+            double peak = range[0] + range[1];
+            cout << "Max abs error:\t\t\t" << error_max << endl;
+            cout << "RMSE:\t\t\t\t" << rmse << endl;
+            cout << "PSNR:\t\t\t\t";
+            if (rmse == 0.0) cout << "inf" << endl;
+            else if (peak > 0.0) cout << 20.0 * log10(peak / rmse) << " dB" << endl;
+            else cout << "n/a (constant data)" << endl;
+        }
+        if (convert_types)
+        {
+            // per rank, the slowest
+            double block_bytes = (double) v.size() * element_size(cfg.memory_type);
+            cout << "Type conversion " << element_type_name(cfg.memory_type) 
+                 << "->" << element_type_name(cfg.file_type) << ":\tHDF5 " 
+                 << block_bytes / conversion_max.hdf5_time / ((double) (1<<20))
+                 << " MB/s, seism-core " 
+                 << block_bytes / conversion_max.own_time / ((double) (1<<20))
+                 << " MB/s" << endl;
+            cout << "Converted differently:\t\t" 
+                 << (unsigned long long) conversion_differences << " of " 
+                 << (unsigned long long) v.size() * mpi_size << endl;
+            if (cfg.own_conversion)
+                cout << "Conversion in writes (max):\t" << own_conversion_max 
+                     << " s" << endl;
+        }
+        if (cfg.halo)
+        {
+            // per rank, the slowest
+            double interior_bytes = (double) v.size() * sizeof(float);
+            cout << "Halo interior (in memory):\tH5Dgather " 
+                 << interior_bytes / halo_max[0] / ((double) (1<<20)) 
+                 << " MB/s, packed " 
+                 << interior_bytes / halo_max[1] / ((double) (1<<20)) 
+                 << " MB/s" << endl;
+            if (cfg.halo_pack)
+                cout << "Halo packing (max):\t\t" << halo_pack_max << " s" 
+                     << endl;
+        }
+        if (alignment)
+            cout << "Aligned chunks:\t\t\t" << total_chunk_counts[1] << " of " 
+                 << total_chunk_counts[0] << endl;
+        // chunks that take elements from more than one block, whose writes
+        // the ranks have to share, and how evenly the work is spread
+        unsigned long long n_chunks = 0;
+        unsigned long long n_shared = shared_chunks(decomposition, cfg.chunk, 
+                &n_chunks);
+        if ((irregular || n_shared) && !cfg.file_groups)
+            cout << "Chunks shared by blocks:\t" << n_shared << " of " << n_chunks 
+                 << " per step and variable" << endl;
+        if (irregular)
+        {
+            vector<double> rank_times(mpi_size, 0.0);
+            for (int r = 0; r < mpi_size; r++)
+                for (unsigned int t = 0; t < cfg.simulation_time; t++)
+                    rank_times[r] += all_step_times[(size_t) r * cfg.simulation_time + t];
+            report_balance("Bytes per rank:\t\t\t", all_bytes, " bytes");
+            report_balance("Write time per rank:\t\t", rank_times, " s");
+        }
+        // only the ranks that call H5Dwrite() count
+        vector<int> writers;
+        vector<double> writer_step_times;
+        vector<char> writer_hosts;
+        for (int r = 0; r < mpi_size; r++)
+        {
+            if (!all_writes_file[r]) continue;
+            writers.push_back(r);
+            writer_step_times.insert(writer_step_times.end(), 
+                    all_step_times.begin() + (size_t) r * cfg.simulation_time,
+                    all_step_times.begin() + (size_t) (r + 1) * cfg.simulation_time);
+            writer_hosts.insert(writer_hosts.end(), 
+                    all_hosts.begin() + (size_t) r * MPI_MAX_PROCESSOR_NAME,
+                    all_hosts.begin() + (size_t) (r + 1) * MPI_MAX_PROCESSOR_NAME);
+        }
+        report_timestep_timings(cfg.timing_file, writer_step_times, 
+                writer_hosts, writers, cfg.simulation_time);
+
+        result.create_time = stop_create - start_create;
+        result.write_time = write_time;
+        result.close_time = fclose_stop - fclose_start;
+        result.write_throughput = bytes_written / write_time / ((double) (1<<20));
+        result.aggregate_throughput = bytes_written / 
+            (fclose_stop - begin + virtual_time) / ((double) (1<<20));
+        result.piece_files = pieces.n_files;
+        result.storage_size = storage_size;
+        result.compression_ratio = 1.0;
+        result.compress_throughput = result.decompress_throughput = 0.0;
+        if (n_stages)
+        {
+            const filter_benchmark& fb = filter_totals.back();
+            result.compression_ratio = fb.raw_bytes / fb.stored_bytes;
+            result.compress_throughput = 
+                fb.raw_bytes / fb.compress_time / ((double) (1<<20));
+            result.decompress_throughput = 
+                fb.raw_bytes / fb.decompress_time / ((double) (1<<20));
+        }
+
+        // the samples for the results store: the slowest writer of each step
+        result.slowdown = 0;
+        if (cfg.results_file[0] || cfg.compare_results[0])
+        {
+            vector<double> step_samples(cfg.simulation_time, 0.0);
+            for (size_t r = 0; r < writers.size(); r++)
+                for (unsigned int t = 0; t < cfg.simulation_time; t++)
+                    step_samples[t] = max(step_samples[t], 
+                        writer_step_times[r * cfg.simulation_time + t]);
+            vector<pair<string, string> > config = results_config(cfg, mpi_size);
+            string config_hash = results_config_hash(config);
+            // compare first, the baseline may be this very store
+            if (cfg.compare_results[0])
+                result.slowdown = compare_with_baseline(cfg, config_hash, 
+                        step_samples, result.write_time);
+            if (cfg.results_file[0])
+                append_result(cfg, config, config_hash, 
+                        environment, result, max_fill_time, 
+                        step_samples);
+        }
         cout << 
         "====================================================================="
              << endl << endl;
 
     }
 
-    if (mpi_rank == 0)
+    if (mpi_rank == 0 && !cfg.subfiling)
     {
         // re-open the file and write the simulation attributes
-        file = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+        file = H5Fopen(cfg.filename, H5F_ACC_RDWR, H5P_DEFAULT);
         assert (file >= 0);
-        char* argv_junk = (char*)use_function_argv_c_str;
-        seismCoreAttributes attr((char*)"my_attr", processor, chunk, domain, 
-                simulation_time, n_nodes, subfile, collective_write, precreate, 
-                set_collective_metadata, never_fill, deflate, zfp,
-                use_function_lib, use_function_name, use_function_argc, 
-                argv_junk );
-        attr.writeAttributesToFile(file);
+        write_simulation_attributes(file, cfg, cfg.domain, 
+                evict_on_close_set, type_scale, decomposition, pieces.n_files);
         herr_retval = H5Fclose(file);
         assert(herr_retval >=0);
     }
 
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Scaling in one job: "scaling weak" or "scaling strong" runs the case on 
+// sub-communicators of the first 1, 2, 4, ... ranks of MPI_COMM_WORLD and
+// finally on all of them, while the other ranks wait. Weak scaling keeps the
+// domain of every rank and grows the global one, strong scaling keeps the 
+// global domain of the input, processor times domain, and divides it among
+// more and more ranks. Each run gets the most nearly cubic processor grid 
+// (which for strong scaling must divide the global domain), and efficiency
+// is write throughput per rank relative to the smallest run.
+
+// the factorization n = grid[0] * grid[1] * grid[2], grid ascending, with the
+// smallest ratio of largest to smallest factor that divides global, if given
+bool scaling_grid(int n, const hsize_t* global, hsize_t* grid)
+{
+    bool found = false;
+    double best = 0.0;
+    for (int a = 1; a <= n; a++)
+    {
+        if (n % a) continue;
+        for (int b = a; b <= n / a; b++)
+        {
+            if ((n / a) % b) continue;
+            int c = n / a / b;
+            if (c < b) break;
+            hsize_t candidate[3] = {(hsize_t) a, (hsize_t) b, (hsize_t) c};
+            if (global && (global[0] % a || global[1] % b || global[2] % c)) 
+                continue;
+            double ratio = (double) c / a;
+            if (!found || ratio < best)
+            {
+                copy(candidate, candidate + 3, grid);
+                best = ratio;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+void report_scaling
+(
+    const seism_core_config&          cfg,
+    const vector<int>&                sizes,
+    const vector<seism_core_config>&  runs,
+    const vector<seism_core_result>&  results
+)
+{
+    bool strong = (cfg.scaling == 2);
+    cout << 
+    "====================================================================="
+         << endl;
+    cout << (strong ? "Strong" : "Weak") << " scaling over " << sizes.size() 
+         << " runs:" << endl;
+    cout << "ranks\tprocessor\tdomain\t\twrite [s]\twrite [MB/s]"
+         << "\taggregate [MB/s]\t" << (strong ? "speedup\t" : "") 
+         << "efficiency" << endl;
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        const seism_core_config& run = runs[i];
+        // throughput per rank, relative to the smallest run
+        double efficiency = (results[i].write_throughput / sizes[i]) 
+            / (results[0].write_throughput / sizes[0]);
+        cout << sizes[i] << "\t" << run.processor[0] << "x" << run.processor[1] 
+             << "x" << run.processor[2] << "\t\t" << run.domain[0] << "x" 
+             << run.domain[1] << "x" << run.domain[2] << "\t" 
+             << results[i].write_time << "\t" << results[i].write_throughput 
+             << "\t\t" << results[i].aggregate_throughput << "\t\t";
+        if (strong) cout << results[0].write_time / results[i].write_time << "\t";
+        cout << efficiency << endl;
+    }
+    cout << 
+    "====================================================================="
+         << endl << endl;
+}
+
+void run_scaling
+(
+    seism_core_config& cfg,
+    int                mpi_thread_provided,
+    seism_core_result& result
+)
+{
+    int mpi_size, mpi_rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
+
+    if (cfg.io_servers)
+    {
+        if (mpi_rank==0) printf("scaling can't be combined with io_servers\nExiting.\n");
+        exit(126);
+    }
+
+    hsize_t global[3];
+    for (int d = 0; d < 3; d++) global[d] = cfg.processor[d] * cfg.domain[d];
+    vector<int> sizes;
+    for (int n = max(cfg.scaling_min, 1); n < mpi_size; n *= 2) sizes.push_back(n);
+    sizes.push_back(mpi_size);
+
+    // the configuration of every run
+    vector<seism_core_config> runs;
+    vector<int> usable;
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        seism_core_config run = cfg;
+        bool strong = (cfg.scaling == 2);
+        if (!scaling_grid(sizes[i], strong ? global : NULL, run.processor))
+        {
+            if (mpi_rank==0) printf("no processor grid of %d ranks divides the "
+                    "domain, skipping it\n", sizes[i]);
+            continue;
+        }
+        for (int d = 0; d < 3; d++)
+        {
+            if (strong) run.domain[d] = global[d] / run.processor[d];
+            run.chunk[d] = min(run.chunk[d], run.processor[d] * run.domain[d]);
+        }
+        // every run gets its own timings, and its own file if it is kept
+        size_t used = strlen(run.timing_file);
+        snprintf(run.timing_file + used, sizeof(run.timing_file) - used, 
+                "-%dranks", sizes[i]);
+        if (cfg.keep_files)
+        {
+            string name = cfg.filename;
+            size_t ext = name.rfind(".h5");
+            if (ext == string::npos) ext = name.size();
+            name.insert(ext, "-" + to_string(sizes[i]) + "ranks");
+            strncpy(run.filename, name.c_str(), 255);
+        }
+        runs.push_back(run);
+        usable.push_back(sizes[i]);
+    }
+    sizes = usable;
+    if (sizes.empty())
+    {
+        if (mpi_rank==0) printf("no run left to scale over\nExiting.\n");
+        exit(126);
+    }
+
+    vector<seism_core_result> results(sizes.size());
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        if (mpi_rank == 0)
+            cout << "Scaling run " << i + 1 << " of " << sizes.size() << ":\t\t"
+                 << sizes[i] << " ranks" << endl;
+        MPI_Comm comm;
+        int mpi_retval = MPI_Comm_split(MPI_COMM_WORLD, 
+                mpi_rank < sizes[i] ? 0 : MPI_UNDEFINED, mpi_rank, &comm);
+        assert(mpi_retval == MPI_SUCCESS);
+        if (comm != MPI_COMM_NULL)
+        {
+            run_case(runs[i], comm, mpi_thread_provided, results[i]);
+            MPI_Comm_free(&comm);
+            if (!cfg.keep_files && mpi_rank == 0) 
+                remove_output(runs[i].filename, results[i].piece_files);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    if (mpi_rank == 0) report_scaling(cfg, sizes, runs, results);
+    result = results.back();
+    for (size_t i = 0; i < results.size(); i++) 
+        result.slowdown |= results[i].slowdown;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+    int mpi_retval = 0;
+    int mpi_size, mpi_rank;
+    int mpi_thread_provided;
+
+    // async_write hands H5Dwrite to a background thread while the main thread
+    // computes; the main thread makes no MPI calls in the meantime. The
+    // background threads of the async VOL connector and the I/O concentrator
+    // threads of the subfiling VFD make theirs at any time.
+    int thread_level = MPI_THREAD_SERIALIZED;
+    const char* vol_connector = getenv("HDF5_VOL_CONNECTOR");
+    if (vol_connector && strstr(vol_connector, "async")) 
+        thread_level = MPI_THREAD_MULTIPLE;
+#ifdef H5_HAVE_SUBFILING_VFD
+    thread_level = MPI_THREAD_MULTIPLE;
+#endif
+    MPI_Init_thread(&argc, &argv, thread_level, &mpi_thread_provided);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
+
+    // rank 0 reads the input, then broadcasts one configuration per case
+    vector<string> cases, labels;
+    int n_cases = 0;
+    if (mpi_rank == 0)
+    {
+        read_cases(cin, cases, labels);
+        n_cases = cases.size();
+    }
+    mpi_retval = MPI_Bcast(&n_cases, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    assert(mpi_retval == MPI_SUCCESS);
+
+    vector<seism_core_result> results(n_cases);
+    for (int i = 0; i < n_cases; i++)
+    {
+        seism_core_config cfg;
+        default_config(cfg);
+        int skip = 0;
+        if (mpi_rank == 0)
+        {
+            istringstream in(cases[i]);
+            parse_config(in, cfg);
+            if (!cfg.timing_file[0])
+            {
+                // seism-test.h5 -> seism-test-timings[-<case>]
+                string name = cfg.filename;
+                if (name.size() >= 3 && !name.compare(name.size() - 3, 3, ".h5"))
+                    name.erase(name.size() - 3);
+                name += "-timings";
+                if (n_cases > 1) name += "-" + to_string(i + 1);
+                snprintf(cfg.timing_file, sizeof(cfg.timing_file), "%s", 
+                        name.c_str());
+            }
+            if (n_cases > 1) 
+                cout << "Case " << i + 1 << " of " << n_cases << ":\t\t" 
+                     << labels[i] << endl;
+            string problem = case_problem(cfg);
+            if (!problem.empty())
+            {
+                cout << "Skipped:\t\t\t" << problem << endl;
+                skip = 1;
+            }
+        }
+        mpi_retval = MPI_Bcast(&cfg, sizeof(cfg), MPI_BYTE, 0, MPI_COMM_WORLD);
+        assert(mpi_retval == MPI_SUCCESS);
+        mpi_retval = MPI_Bcast(&skip, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        assert(mpi_retval == MPI_SUCCESS);
+        if (skip)
+        {
+            results[i].skipped = 1;
+            continue;
+        }
+
+        if (cfg.scaling) run_scaling(cfg, mpi_thread_provided, results[i]);
+        else run_case(cfg, MPI_COMM_WORLD, mpi_thread_provided, results[i]);
+
+        // in a sweep, remove each file before the next case runs
+        if (n_cases > 1 && !cfg.keep_files && mpi_rank == 0) 
+            remove_output(cfg.filename, results[i].piece_files);
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    if (mpi_rank == 0 && n_cases > 1) report_sweep(labels, results);
+
+    // a slowdown against the baseline fails the job, for scripts to act on
+    int slowdowns = 0;
+    for (int i = 0; i < n_cases; i++) slowdowns += results[i].slowdown;
+    mpi_retval = MPI_Bcast(&slowdowns, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    assert(mpi_retval == MPI_SUCCESS);
+    if (mpi_rank == 0 && slowdowns) 
+        cout << "Slower than the baseline:\t" << slowdowns << " of " << n_cases 
+             << " cases" << endl;
+
+    // skipped cases are invalid input, as for a single case
+    int skipped = 0;
+    for (int i = 0; i < n_cases; i++) skipped += results[i].skipped;
+    if (mpi_rank == 0 && skipped) 
+        cout << "Skipped:\t\t\t" << skipped << " of " << n_cases 
+             << " cases" << endl;
+
     MPI_Finalize();
 
-    return 0;
+    if (skipped) return 126;
+    return slowdowns ? 1 : 0;
 }
 
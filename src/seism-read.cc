@@ -5,7 +5,28 @@
 // object in input h5 file) contains info on data size, subfiling, etc.
 // usage: 
 // 
-// mpiexec seism-read input-file.h5
+// mpiexec seism-read input-file.h5 [--ignore-subfile] [--pattern P[,P...]]
+//                    [--collective] [--step S] [--stride K] [--index I]
+//                    [--points N]
+//
+// Read patterns, each reported separately:
+//
+// block      every rank reads its own block of timestep S (default 0); all
+//            ranks together read a full-volume snapshot (the default)
+// steps      every rank reads its own block of every K-th timestep
+// plane-x    for every K-th timestep, the plane at index I (default: middle)
+// plane-y    perpendicular to the x, y or z axis, split in strips over the
+// plane-z    ranks
+// pencil     every rank reads the time series at N (default 16) random points
+// random     every rank reads N (default 1000) random chunks of random
+//            timesteps, or the fraction F (--read-fraction) of their rows
+// all        all of the above
+//
+// --collective uses collective instead of independent transfers.
+// --queue-depth Q keeps up to Q independent reads in flight per rank, one
+// thread each. Unless HDF5 is thread-safe, the threads take turns inside the
+// library; with --direct, reads that fall within one unfiltered chunk go
+// straight to the file with pread() at the chunk's address instead.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -18,16 +39,302 @@
 #include <sstream>
 #include <vector>
 #include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "seism-core-attributes.hh"
+#include "seism-core-decomposition.hh"
+#include "seism-core-element.hh"
 
 using namespace std;
 
+///////////////////////////////////////////////////////////////////////////////
+// One hyperslab read in (time, x, y, z). A zero block is an empty selection,
+// issued only so that every rank takes part in every collective read.
+
+struct read_op
+{
+    hsize_t start[4];
+    hsize_t block[4];
+};
+
+hsize_t read_op_size(const read_op& op)
+{
+    return op.block[0] * op.block[1] * op.block[2] * op.block[3];
+}
+
+read_op make_read_op(hsize_t t, hsize_t x, hsize_t y, hsize_t z,
+                     hsize_t nt, hsize_t nx, hsize_t ny, hsize_t nz)
+{
+    read_op op = {{t, x, y, z}, {nt, nx, ny, nz}};
+    return op;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// the reads this rank does for a pattern; every rank returns the same number
+
+vector<read_op> make_reads
+(
+    const string&                   pattern,
+    const seismCoreAttributes&      attr,
+    const seism_core_decomposition& decomposition,
+    const hsize_t*                  dims,     // time, x, y, z extents of the file
+    int                             mpi_rank,
+    int                             mpi_size,
+    hsize_t                         step,
+    hsize_t                         stride,
+    long                            index,    // plane index, < 0 for the middle
+    int                             n_points,
+    const hsize_t*                  chunk_dims,
+    int                             n_random,
+    double                          read_fraction
+)
+{
+    vector<read_op> reads;
+
+    // this rank's block in the process grid, as written by seism-core;
+    // ranks beyond the writer's process grid have no block of their own
+    hsize_t n_blocks = attr.processor_dims[0] * attr.processor_dims[1] * attr.processor_dims[2];
+    bool has_block = (hsize_t) mpi_rank < n_blocks;
+    hsize_t number[3], origin[3] = {0, 0, 0}, size[3] = {0, 0, 0};
+    number[2] = (hsize_t) mpi_rank % attr.processor_dims[2];
+    number[1] = (hsize_t) (mpi_rank / attr.processor_dims[2]) % attr.processor_dims[1];
+    number[0] = (hsize_t) (mpi_rank / attr.processor_dims[2]) / attr.processor_dims[1];
+    if (has_block) decomposition_block(decomposition, number, origin, size);
+
+    if (pattern == "block" || pattern == "steps")
+    {
+        hsize_t first = (pattern == "block") ? step : 0;
+        hsize_t last = (pattern == "block") ? step + 1 : dims[0];
+        for (hsize_t t = first; t < last; t += stride)
+        {
+            if (has_block) 
+                reads.push_back(make_read_op(t, origin[0], origin[1], origin[2],
+                            1, size[0], size[1], size[2]));
+            else reads.push_back(make_read_op(0, 0, 0, 0, 0, 0, 0, 0));
+        }
+    }
+    else if (!pattern.compare(0, 6, "plane-"))
+    {
+        // axis normal to the plane, and the axis the strips are cut along
+        int normal = 1 + (pattern[6] - 'x');
+        assert(normal >= 1 && normal <= 3);
+        int split = (normal == 1) ? 2 : 1;
+        hsize_t at = (index < 0) ? dims[normal] / 2 : (hsize_t) index;
+        assert(at < dims[normal]);
+        hsize_t rows = (dims[split] + mpi_size - 1) / mpi_size;
+        hsize_t first = min(dims[split], rows * mpi_rank);
+        hsize_t last = min(dims[split], first + rows);
+
+        for (hsize_t t = 0; t < dims[0]; t += stride)
+        {
+            read_op op = make_read_op(t, 0, 0, 0, 1, dims[1], dims[2], dims[3]);
+            op.start[normal] = at;
+            op.block[normal] = 1;
+            op.start[split] = first;
+            op.block[split] = last - first;
+            if (last == first) op = make_read_op(0, 0, 0, 0, 0, 0, 0, 0);
+            reads.push_back(op);
+        }
+    }
+    else if (pattern == "random")
+    {
+        // whole chunks, or a contiguous run of rows inside one
+        unsigned int seed = 54321 + mpi_rank;
+        hsize_t rows = max((hsize_t) 1, (hsize_t) (read_fraction * chunk_dims[1]));
+        for (int r = 0; r < n_random; r++)
+        {
+            read_op op = make_read_op(rand_r(&seed) % dims[0], 0, 0, 0, 1, 
+                    min(rows, chunk_dims[1]), chunk_dims[2], chunk_dims[3]);
+            for (int d = 1; d < 4; d++)
+            {
+                hsize_t n_chunks = (dims[d] + chunk_dims[d] - 1) / chunk_dims[d];
+                op.start[d] = (rand_r(&seed) % n_chunks) * chunk_dims[d];
+                // a chunk at the edge ends with the dataset
+                hsize_t extent = min(chunk_dims[d], dims[d] - op.start[d]);
+                op.block[d] = min(op.block[d], extent);
+                if (d == 1) op.start[d] += rand_r(&seed) % (extent - op.block[d] + 1);
+            }
+            reads.push_back(op);
+        }
+    }
+    else if (pattern == "pencil")
+    {
+        unsigned int seed = 12345 + mpi_rank;
+        for (int p = 0; p < n_points; p++)
+        {
+            hsize_t x = rand_r(&seed) % dims[1];
+            hsize_t y = rand_r(&seed) % dims[2];
+            hsize_t z = rand_r(&seed) % dims[3];
+            reads.push_back(make_read_op(0, x, y, z, dims[0], 1, 1, 1));
+        }
+    }
+    else
+    {
+        if (mpi_rank == 0) cout << "Unknown read pattern " << pattern << endl;
+    }
+
+    return reads;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Everything a reader thread needs. Thread t does reads t, t + Q, t + 2Q...
+// so that at most Q reads are in flight per rank.
+
+struct read_queue
+{
+    hid_t                   dset;
+    hid_t                   dxpl;
+    const vector<read_op>*  reads;
+    vector<haddr_t>         address;   // chunk address for direct reads
+    vector<double>          latency;   // < 0 for empty reads
+    const char*             filename;
+    int                     queue_depth;
+    bool                    serialize; // HDF5 is not thread-safe
+    mutex                   h5_lock;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Byte address of the data of a read that lies within one unfiltered chunk,
+// or HADDR_UNDEF if it has to go through H5Dread.
+
+haddr_t direct_address
+(
+    hid_t           dset,
+    const hsize_t*  chunk_dims,
+    const read_op&  op
+)
+{
+    haddr_t address = HADDR_UNDEF;
+#if H5_VERSION_GE(1,10,5)
+    hsize_t offset[4];
+    for (int d = 0; d < 4; d++)
+    {
+        offset[d] = op.start[d] - op.start[d] % chunk_dims[d];
+        if (op.start[d] + op.block[d] > offset[d] + chunk_dims[d]) return HADDR_UNDEF;
+    }
+    // the read must be a contiguous run of rows of the chunk
+    if (op.block[2] != chunk_dims[2] || op.block[3] != chunk_dims[3] || op.block[0] != 1)
+        return HADDR_UNDEF;
+
+    unsigned filter_mask = 0;
+    hsize_t size = 0;
+    herr_t herr_retval = H5Dget_chunk_info_by_coord(dset, offset, &filter_mask, 
+            &address, &size);
+    if (herr_retval < 0 || filter_mask) return HADDR_UNDEF;
+    if (address != HADDR_UNDEF) 
+        address += sizeof(float) * (op.start[1] - offset[1]) * chunk_dims[2] * chunk_dims[3];
+#endif
+    return address;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void read_thread(read_queue* queue, int t)
+{
+    const vector<read_op>& reads = *queue->reads;
+    hsize_t buffer_size = 1;
+    for (size_t r = t; r < reads.size(); r += queue->queue_depth) 
+        buffer_size = max(buffer_size, read_op_size(reads[r]));
+    vector<float> buffer(buffer_size);
+    hsize_t stride[4] = {1,1,1,1};
+    hsize_t count[4] = {1,1,1,1};
+    herr_t herr_retval;
+
+    int fd = -1;
+    if (!queue->address.empty()) 
+    {
+        fd = open(queue->filename, O_RDONLY);
+        assert(fd >= 0);
+    }
+
+    unique_lock<mutex> guard(queue->h5_lock, defer_lock);
+    for (size_t r = t; r < reads.size(); r += queue->queue_depth)
+    {
+        hsize_t n = read_op_size(reads[r]);
+        // MPI_Wtime() would be an MPI call from several threads at once
+        chrono::steady_clock::time_point begin_op = chrono::steady_clock::now();
+
+        if (fd >= 0 && queue->address[r] != HADDR_UNDEF)
+        {
+            size_t bytes = sizeof(float) * n;
+            ssize_t got = pread(fd, &buffer[0], bytes, (off_t) queue->address[r]);
+            assert(got == (ssize_t) bytes);
+        }
+        else
+        {
+            if (queue->serialize) guard.lock();
+            hid_t fspace = H5Dget_space(queue->dset);
+            assert (fspace >= 0);
+            hsize_t mdims[1] = {max(n, (hsize_t) 1)};
+            hid_t mspace = H5Screate_simple(1, mdims, NULL);
+            assert (mspace >= 0);
+            if (n)
+            {
+                // select hyperslab within file dataspace
+                herr_retval = H5Sselect_hyperslab( fspace, H5S_SELECT_SET, 
+                        reads[r].start, stride, count, reads[r].block );
+                assert (herr_retval >= 0 );
+            }
+            else
+            {
+                herr_retval = H5Sselect_none(fspace);
+                assert (herr_retval >= 0);
+                herr_retval = H5Sselect_none(mspace);
+                assert (herr_retval >= 0);
+            }
+
+            // read the dataset into the buffer
+            herr_retval = H5Dread (queue->dset, H5T_NATIVE_FLOAT, mspace, fspace, 
+                    queue->dxpl, &buffer[0]);
+            assert(herr_retval >= 0);
+            H5Sclose(mspace);
+            H5Sclose(fspace);
+            if (queue->serialize) guard.unlock();
+        }
+
+        if (n) queue->latency[r] = chrono::duration<double>(
+                chrono::steady_clock::now() - begin_op).count();
+    }
+
+    if (fd >= 0) close(fd);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// log2 histogram of latencies in microseconds: bin b counts [2^b, 2^(b+1)) us
+
+const int latency_bins = 32;
+
+void print_latency_histogram(const vector<long>& histogram)
+{
+    int first = 0, last = latency_bins - 1;
+    while (first < last && !histogram[first]) first++;
+    while (last > first && !histogram[last]) last--;
+    cout << "Read latency histogram:" << endl;
+    for (int b = first; b <= last; b++)
+    {
+        ostringstream bin;
+        bin << "  < " << (1L << (b + 1)) << " us:";
+        cout << bin.str() << string(32 - bin.str().size(), ' ') << histogram[b] << endl;
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
   
 int main(int argc, char** argv)
 {
-    MPI_Init(&argc, &argv);
+    // reader threads may call into MPI-IO, one at a time, and the I/O 
+    // concentrator threads of the subfiling VFD at any time
+    int mpi_thread_provided;
+#ifdef H5_HAVE_SUBFILING_VFD
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &mpi_thread_provided);
+#else
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_thread_provided);
+#endif
     int mpi_rank, mpi_size;
     MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
     MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
@@ -42,6 +349,55 @@ int main(int argc, char** argv)
     }
     char* filename = argv[1];
 
+    // read patterns and their parameters
+    vector<string> patterns;
+    int collective_read = 0;
+    hsize_t step = 0, stride = 1;
+    long index = -1;
+    int n_points = 16;
+    int n_random = 1000;
+    double read_fraction = 1.0;
+    int queue_depth = 1;
+    bool direct = false;
+    for (int i = 2; i<argc; i++)
+    {
+        if (!strcmp(argv[i], "--collective")) collective_read = 1;
+        if (!strcmp(argv[i], "--direct")) direct = true;
+        if (i + 1 >= argc) continue;
+        if (!strcmp(argv[i], "--step")) step = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--stride")) stride = max(1L, atol(argv[++i]));
+        else if (!strcmp(argv[i], "--index")) index = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--points")) n_points = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--reads")) n_random = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--read-fraction")) read_fraction = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--queue-depth")) queue_depth = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--pattern"))
+        {
+            string item;
+            istringstream list(argv[++i]);
+            while (getline(list, item, ',')) 
+            {
+                if (item == "all")
+                {
+                    const char* all[] = {"block", "steps", "plane-x", 
+                        "plane-y", "plane-z", "pencil", "random"};
+                    patterns.insert(patterns.end(), all, all + 7);
+                }
+                else patterns.push_back(item);
+            }
+        }
+    }
+    if (patterns.empty()) patterns.push_back("block");
+
+    // collective reads are issued one at a time by every rank
+    if (collective_read) queue_depth = 1;
+    if (queue_depth > 1 && mpi_thread_provided < MPI_THREAD_SERIALIZED)
+    {
+        if (mpi_rank == 0) cout << "MPI_THREAD_SERIALIZED not provided, "
+                                << "using a queue depth of 1" << endl;
+        queue_depth = 1;
+    }
+
     if (mpi_rank == 0){
         cout << endl
              << "=====================================================================" 
@@ -49,9 +405,74 @@ int main(int argc, char** argv)
         cout << "Reading " << filename << endl;
     }
     
-    // open file to read the attributes
-    hid_t file = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+    // open file to read the attributes; everybody opens it, so collective
+    // transfers are possible
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    assert (fapl >= 0);
+    herr_retval = H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+    assert (herr_retval >= 0);
+#ifdef H5_HAVE_SUBFILING_VFD
+    // to MPI-IO a subfiled file is a stub without the data; the subfiling 
+    // VFD takes the stripe size and the subfiles from the file
+    hid_t file = H5I_INVALID_HID;
+    H5E_BEGIN_TRY {
+        file = H5Fopen(filename, H5F_ACC_RDONLY, fapl);
+    } H5E_END_TRY;
+    if (file < 0 && mpi_thread_provided < MPI_THREAD_MULTIPLE)
+    {
+        if (mpi_rank == 0) cout << "Can't open " << filename << " with MPI-IO, "
+            "and the subfiling VFD needs MPI_THREAD_MULTIPLE." << endl;
+        MPI_Finalize();
+        return(1);
+    }
+    if (file < 0)
+    {
+        herr_retval = H5Pset_mpi_params(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+        assert (herr_retval >= 0);
+        herr_retval = H5Pset_fapl_subfiling(fapl, NULL);
+        assert (herr_retval >= 0);
+        file = H5Fopen(filename, H5F_ACC_RDONLY, fapl);
+    }
+#else
+    hid_t file = H5Fopen(filename, H5F_ACC_RDONLY, fapl);
+#endif
+    if (file < 0)
+    {
+        if (mpi_rank == 0) cout << "Can't open " << filename << "." << endl;
+        MPI_Finalize();
+        return(1);
+    }
+    herr_retval = H5Pclose(fapl);
+    assert (herr_retval >= 0);
     seismCoreAttributes attr(file);
+
+    // files written before the element types were stored read them back as
+    // NULL: floats
+    if (!attr.element_type) attr.element_type = (char*) "f32";
+    if (!attr.memory_type) attr.memory_type = (char*) "f32";
+    int file_type = max(element_type_of(attr.element_type), 0);
+
+    // piece files are read through the virtual dataset, with the file opened
+    // by every rank on its own: parallel HDF5 would open the source files 
+    // collectively whenever a read first touches them
+    if (attr.piece_files)
+    {
+        H5Fclose(file);
+        file = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+        assert(file >= 0);
+        if (collective_read && mpi_rank == 0)
+            cout << "Collective reads need one shared file; disabled" << endl;
+        collective_read = 0;
+    }
+    seism_core_decomposition decomposition;
+    if (!read_decomposition(attr.decomposition, attr.processor_dims, 
+                attr.domain_dims, decomposition))
+    {
+        if (mpi_rank == 0) cout << "The decomposition " << attr.decomposition 
+            << " doesn't match the process grid." << endl;
+        MPI_Finalize();
+        return(1);
+    }
     if (mpi_rank == 0){
         cout << endl;
         cout << "processor layout:\t\t";
@@ -62,6 +483,28 @@ int main(int argc, char** argv)
         cout << attr.domain_dims[0] << ":";
         cout << attr.domain_dims[1] << ":";
         cout << attr.domain_dims[2] << endl;
+        if (attr.decomposition && attr.decomposition[0])
+            cout << "decomposition:\t\t\t" << attr.decomposition << endl;
+        if (attr.piece_files)
+            cout << "piece files:\t\t\t" << attr.piece_files 
+                 << " (read through the virtual dataset)" << endl;
+        if (attr.subfiling)
+        {
+            cout << "subfiling VFD:\t\t\tstripe size ";
+            if (attr.subfiling_stripe_size) cout << attr.subfiling_stripe_size;
+            else cout << "default";
+            cout << ", I/O concentrators ";
+            if (attr.subfiling_ioc && attr.subfiling_ioc[0]) 
+                cout << attr.subfiling_ioc << endl;
+            else cout << "default" << endl;
+        }
+        if (attr.file_space_strategy && attr.file_space_strategy[0])
+            cout << "file space strategy:\t\t" << attr.file_space_strategy 
+                 << " (page size " << attr.file_space_page_size << ")" << endl;
+        if (attr.meta_block_size)
+            cout << "metadata block size:\t\t" << attr.meta_block_size << endl;
+        cout << "element types:\t\t\t" << attr.memory_type << " in memory, " 
+             << attr.element_type << " in the file (read as f32)" << endl;
         cout << endl;
     }
     
@@ -118,55 +561,164 @@ int main(int argc, char** argv)
     hid_t dset = H5Dopen (file, "chunked", H5P_DEFAULT);
     assert (dset >= 0);
 
-    // create a buffer to hold one domain worth of data
-    hsize_t domain_size = 
-        attr.domain_dims[0] * attr.domain_dims[1] * attr.domain_dims[2];
-    float *buffer = (float *)malloc(sizeof(float) * domain_size);
-
-    // calculate offsets from MPI rank
-    hsize_t start[4];
-    start[3] = (hsize_t) mpi_rank % attr.processor_dims[2];
-    start[2] = (hsize_t) ((mpi_rank - start[3])/attr.processor_dims[2]) % attr.processor_dims[1];
-    start[1] = (hsize_t) ((mpi_rank - start[3])/attr.processor_dims[2] - start[2]) / attr.processor_dims[1];
-    start[0] = 0; // because we can only do single time step with current subfiling implementation
-
-    // adjust start point by attr.domain_dims
-    start[1] *= attr.domain_dims[0];
-    start[2] *= attr.domain_dims[1];
-    start[3] *= attr.domain_dims[2];
-
     // get the dataspace
     hid_t fspace = H5Dget_space(dset);
     assert(fspace >= 0);
-    hsize_t stride[4] = {1,1,1,1};
-    hsize_t count[4] = {1,1,1,1};
-    hsize_t block[4] = {1, attr.domain_dims[0], attr.domain_dims[1], attr.domain_dims[2]};
+    hsize_t dims[4];
+    assert(H5Sget_simple_extent_ndims(fspace) == 4);
+    H5Sget_simple_extent_dims(fspace, dims, NULL);
+
+    // chunk dimensions, for the random pattern and direct reads; a virtual
+    // dataset has none, its piece files were chunked as the input said
+    hsize_t chunk_dims[4];
+    hid_t dcpl = H5Dget_create_plist(dset);
+    assert (dcpl >= 0);
+    bool is_virtual = H5Pget_layout(dcpl) == H5D_VIRTUAL;
+    if (is_virtual)
+    {
+        // seism-core reduces the chunks of the input to the piece files they
+        // don't fit; take the smallest piece, the extent of a mapping's source
+        chunk_dims[0] = 1;
+        for (int d = 0; d < 3; d++) 
+            chunk_dims[d + 1] = min(attr.chunk_dims[d], dims[d + 1]);
+        size_t n_mappings = 0;
+        herr_retval = H5Pget_virtual_count(dcpl, &n_mappings);
+        assert(herr_retval >= 0);
+        for (size_t i = 0; i < n_mappings; i++)
+        {
+            hid_t source = H5Pget_virtual_srcspace(dcpl, i);
+            assert(source >= 0);
+            hsize_t piece[4];
+            int piece_rank = H5Sget_simple_extent_dims(source, piece, NULL);
+            assert(piece_rank == 4);
+            for (int d = 1; d < 4; d++) chunk_dims[d] = min(chunk_dims[d], piece[d]);
+            H5Sclose(source);
+        }
+    }
+    else
+    {
+        int chunk_rank = H5Pget_chunk(dcpl, 4, chunk_dims);
+        assert (chunk_rank == 4);
+    }
+    // direct reads copy the stored bytes into floats
+    bool use_direct = direct && !subfile && !attr.subfiling && !is_virtual && 
+        H5Pget_nfilters(dcpl) == 0 && file_type == ELEMENT_F32;
+    if (direct && !use_direct && mpi_rank == 0) 
+        cout << "Direct reads need an unfiltered, single file of floats; "
+            "disabled" << endl;
+    H5Pclose(dcpl);
 
-    // select hyperslab within file dataspace
-    herr_retval = H5Sselect_hyperslab( fspace, H5S_SELECT_SET, start, stride, count, block );
-    assert (herr_retval >= 0 );
+    hid_t dxpl = H5Pcreate(H5P_DATASET_XFER);
+    assert(dxpl >= 0);
+    if (collective_read)
+    {
+        herr_retval = H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+        assert(herr_retval >= 0);
+    }
+
+    for (size_t p = 0; p < patterns.size(); p++)
+    {
+        vector<read_op> reads = make_reads(patterns[p], attr, decomposition, 
+                dims, mpi_rank,
+                mpi_size, step, stride, index, n_points, chunk_dims, n_random,
+                read_fraction);
+        if (reads.empty()) continue;
+
+        read_queue queue;
+        queue.dset = dset;
+        queue.dxpl = dxpl;
+        queue.reads = &reads;
+        queue.latency.assign(reads.size(), -1.0);
+        queue.filename = filename;
+        queue.queue_depth = queue_depth;
+        hbool_t threadsafe = 0;
+        H5is_library_threadsafe(&threadsafe);
+        queue.serialize = !threadsafe;
 
-    hid_t mspace = H5Screate_simple(4, block, NULL);
-    assert (mspace >= 0);
-    assert (H5Sselect_all(mspace) >= 0);
+        // look up chunk addresses before the clock starts, as an
+        // interactive reader would have its chunk index cached
+        long n_direct = 0;
+        if (use_direct)
+        {
+            queue.address.resize(reads.size());
+            for (size_t r = 0; r < reads.size(); r++)
+            {
+                queue.address[r] = read_op_size(reads[r]) ? 
+                    direct_address(dset, chunk_dims, reads[r]) : HADDR_UNDEF;
+                if (queue.address[r] != HADDR_UNDEF) n_direct++;
+            }
+        }
+
+        double local_bytes = 0.0;
+        for (size_t r = 0; r < reads.size(); r++) 
+            local_bytes += sizeof(float) * (double) read_op_size(reads[r]);
 
-    // read the dataset into the buffer
-    double begin_read = MPI_Wtime();
-    herr_retval = H5Dread (dset, H5T_NATIVE_FLOAT, mspace, fspace, H5P_DEFAULT, buffer);
-    assert(herr_retval >= 0);
-    double end_read = MPI_Wtime();
+        MPI_Barrier(MPI_COMM_WORLD);
+        double begin_read = MPI_Wtime();
+
+        if (queue_depth == 1) read_thread(&queue, 0);
+        else
+        {
+            vector<thread> threads;
+            for (int t = 0; t < queue_depth; t++) 
+                threads.push_back(thread(read_thread, &queue, t));
+            for (int t = 0; t < queue_depth; t++) threads[t].join();
+        }
+        vector<double>& latency = queue.latency;
 
-    double _read_time = end_read - begin_read;
-    double read_time;
+        MPI_Barrier(MPI_COMM_WORLD);
+        double read_time = MPI_Wtime() - begin_read;
+
+        double data_size = 0.0;
+        MPI_Reduce(&local_bytes, &data_size, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        vector<double> all_latency(mpi_rank == 0 ? reads.size() * mpi_size : 0);
+        MPI_Gather(&latency[0], reads.size(), MPI_DOUBLE, all_latency.data(),
+                reads.size(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        long total_direct = 0;
+        MPI_Reduce(&n_direct, &total_direct, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+        if (mpi_rank == 0){
+            // drop the empty reads, then sort for the percentiles
+            all_latency.erase(remove_if(all_latency.begin(), all_latency.end(),
+                        [](double l) { return l < 0.0; }), all_latency.end());
+            sort(all_latency.begin(), all_latency.end());
+            double mean = 0.0;
+            for (size_t r = 0; r < all_latency.size(); r++) mean += all_latency[r];
+            if (!all_latency.empty()) mean /= all_latency.size();
+
+            double throughput_MB = (1.0e-6 * data_size) / read_time;
+            cout << endl;
+            cout << "Read pattern:\t\t\t" << patterns[p] << endl;
+            cout << "Reads per rank:\t\t\t" << reads.size() << endl;
+            cout << "Collective:\t\t\t" << collective_read << endl;
+            cout << "Queue depth:\t\t\t" << queue_depth << endl;
+            if (use_direct) 
+                cout << "Direct reads:\t\t\t" << total_direct << endl;
+            cout << "Total bytes read:\t\t" << (unsigned long) data_size << endl;
+            cout << "Read time: \t\t\t" << read_time << " s"  << endl;
+            cout << "Read throughput: \t\t" << throughput_MB << " MB/s" << endl;
+            cout << "Read IOPS:\t\t\t" << all_latency.size() / read_time << endl;
+            if (!all_latency.empty())
+            {
+                size_t n = all_latency.size();
+                cout << "Read latency min/mean/p99/max:\t" << all_latency.front()
+                     << " / " << mean << " / " 
+                     << all_latency[min(n - 1, (size_t) (0.99 * n))]
+                     << " / " << all_latency.back() << " s" << endl;
+
+                vector<long> histogram(latency_bins, 0);
+                for (size_t r = 0; r < n; r++)
+                {
+                    int b = 0;
+                    while (b < latency_bins - 1 && all_latency[r] * 1.0e6 >= (1L << (b + 1))) b++;
+                    histogram[b]++;
+                }
+                print_latency_histogram(histogram);
+            }
+        }
+    }
 
-    MPI_Reduce(&_read_time, &read_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
     if (mpi_rank == 0){
-        unsigned long data_size = sizeof(float) * mpi_size * domain_size;
-        double throughput_MB = (1.0e-6 * data_size) / read_time;
-        cout << endl;
-        cout << "Total bytes read:\t\t" << data_size << endl;
-        cout << "Read time: \t\t\t" << read_time << " s"  << endl;
-        cout << "Read throughput: \t\t" << throughput_MB << " MB/s" << endl;
         cout << "seism-read done. " << endl << endl;
         cout << "=====================================================================" 
              << endl;
@@ -174,7 +726,7 @@ int main(int argc, char** argv)
     
     attr.finalize(); // will finalize/dispose of internal H5 resources
     H5Sclose(fspace);
-    H5Sclose(mspace);
+    H5Pclose(dxpl);
     H5Dclose(dset);
     H5Fclose(file);
 